@@ -278,28 +278,11 @@ void ACaptureSceneComponent::FillFrameData(float DeltaTime, FString Name, UTextu
 		Aux2DTex->GetPlatformData()->Mips[0].BulkData.Unlock();
 		return;
 	}
-	for (int32 Y = 0; Y < ALPHA_MAP_HEIGHT; Y++)
-	{
-		for (int32 X = 0; X < ALPHA_MAP_WIDTH; X++)
-		{
-			int index = Y * ALPHA_MAP_WIDTH + X;
-			FColor Color = FormattedImageData[index];
-			BufferTexture->SetPixel(X, Y, Color.ReinterpretAsLinear());
-
-			if (Y == 0 && (X == 0 || X == 1) && false) {
-				if (Color.R > 0 || Color.B > 0 || Color.G > 0) {
-					UE_LOG(LogTemp, Warning, TEXT("Buffer Texture Index: %i, X: %i, Y:%i"), index, X, Y);
-					UE_LOG(LogTemp, Warning, TEXT("Red: %i"), static_cast<int>(Color.ReinterpretAsLinear().R * 255));
-					UE_LOG(LogTemp, Warning, TEXT("Green, %i"), static_cast<int>(Color.ReinterpretAsLinear().G * 255));
-					UE_LOG(LogTemp, Warning, TEXT("Blue: %i"), static_cast<int>(Color.ReinterpretAsLinear().B * 255));
-					UE_LOG(LogTemp, Warning, TEXT("Alpha: %i"), static_cast<int>(Color.ReinterpretAsLinear().A * 255));
-				}
-			}
-		}
-	}
+	BufferTexture->WritePixels(0, 0, ALPHA_MAP_WIDTH, ALPHA_MAP_HEIGHT, FormattedImageData, ALPHA_MAP_WIDTH);
 	BufferTexture->UpdateTexture();
-	FDynamicTextureBuffer Buffer = BufferTexture->ExternalBuffer;
-	TArray<uint8> PixelColorValues = Buffer.PixelBuffer;
+	FDynamicTextureSnapshot Snapshot = BufferTexture->GetSnapshot();
+	const TArray<uint8> NoPixels;
+	const TArray<uint8>& PixelColorValues = Snapshot.IsValid() ? Snapshot->Pixels : NoPixels;
 
 	for (int32 Y = 0; Y < ALPHA_MAP_HEIGHT; Y++)
 	{
@@ -3,32 +3,79 @@
 
 #include "DynamicTexture.h"
 
-// UTextures have a BPP of 4 (Red, Green, Blue, Alpha)
-#define DYNAMIC_TEXTURE_BYTES_PER_PIXEL 4
+// Writes Count copies of a pixel starting at Dest. Four byte pixels are written four at a
+// time with vector stores, and pixels made of one repeated byte become a memset.
+template<typename TPixelTraits>
+static void FillPixelSpan(typename TPixelTraits::FPixel* Dest, int32 Count, const typename TPixelTraits::FPixel& Pixel)
+{
+	typedef typename TPixelTraits::FPixel FPixel;
+
+	const uint8* PixelBytes = reinterpret_cast<const uint8*>(&Pixel);
+	bool bSingleByte = true;
+	for (int32 i = 1; i < int32(sizeof(FPixel)); i++)
+	{
+		bSingleByte &= PixelBytes[i] == PixelBytes[0];
+	}
+	if (bSingleByte)
+	{
+		FMemory::Memset(Dest, PixelBytes[0], SIZE_T(Count) * sizeof(FPixel));
+		return;
+	}
+
+	int32 i = 0;
+	if constexpr (sizeof(FPixel) == 4)
+	{
+		int32 Pattern;
+		FMemory::Memcpy(&Pattern, &Pixel, sizeof(Pattern));
+		const VectorRegister4Int PatternRegister = VectorIntSet1(Pattern);
+		for (; i + 4 <= Count; i += 4)
+		{
+			VectorIntStore(PatternRegister, Dest + i);
+		}
+	}
+	for (; i < Count; i++)
+	{
+		Dest[i] = Pixel;
+	}
+}
 
-void UDynamicTexture::Initialize(int32 InWidth, int32 InHeight, FLinearColor InClearColor, TextureFilter FilterMethod/* = TextureFilter::TF_Nearest*/)
+void UDynamicTexture::Initialize(int32 InWidth, int32 InHeight, FLinearColor InClearColor, TextureFilter FilterMethod/* = TextureFilter::TF_Nearest*/, EDynamicTexturePixelFormat InPixelFormat/* = EDynamicTexturePixelFormat::BGRA8*/)
 {
 	// Store the parameters
 	TextureWidth = InWidth;
 	TextureHeight = InHeight;
 	ClearColor = InClearColor;
+	PixelFormat = InPixelFormat;
+	BytesPerPixel = GetDynamicTextureBytesPerPixel(PixelFormat);
 
-	// Create the UTexture2D to render to
-	Texture = UTexture2D::CreateTransient(TextureWidth, TextureHeight);
+	// Create the UTexture2D to render to, with the settings of the chosen format
+	DispatchDynamicTexturePixelFormat(PixelFormat, [this](auto Traits)
+	{
+		typedef decltype(Traits) TPixelTraits;
+		Texture = UTexture2D::CreateTransient(TextureWidth, TextureHeight, TPixelTraits::TextureFormat);
+		Texture->CompressionSettings = TPixelTraits::Compression;
+		Texture->SRGB = TPixelTraits::bSRGB;
+	});
 	Texture->MipGenSettings = TextureMipGenSettings::TMGS_NoMipmaps;
-	Texture->CompressionSettings = TextureCompressionSettings::TC_VectorDisplacementmap; // The VectorDisplacementMap is a raw RGBA8 format
-	Texture->SRGB = 1;
 	Texture->Filter = FilterMethod;
 	Texture->UpdateResource();
 
-	// Create the proxy object for updating the texture region
-	UpdateTextureRegionProxy = MakeUnique<FUpdateTextureRegion2D>(0, 0, 0, 0, TextureWidth, TextureHeight);
-
 	// Size of the image pixel buffer
-	SIZE_T BufferSize = TextureWidth * TextureHeight * DYNAMIC_TEXTURE_BYTES_PER_PIXEL;
-	UE_LOG(LogTemp, Warning, TEXT("Making Buffer of width: %i\theight: %i\tsize: %i"), TextureWidth, TextureHeight, TextureWidth * TextureHeight * DYNAMIC_TEXTURE_BYTES_PER_PIXEL);
+	SIZE_T BufferSize = TextureWidth * TextureHeight * BytesPerPixel;
+	UE_LOG(LogTemp, Warning, TEXT("Making Buffer of width: %i\theight: %i\tsize: %i"), TextureWidth, TextureHeight, TextureWidth * TextureHeight * BytesPerPixel);
 
-	PixelBuffer = MakeUnique<uint8[]>(BufferSize);
+	BackFrame = MakeShared<FDynamicTextureFrame, ESPMode::ThreadSafe>();
+	BackFrame->Pixels.SetNumUninitialized(BufferSize);
+	BackFrame->Width = TextureWidth;
+	BackFrame->Height = TextureHeight;
+	BackFrame->Format = PixelFormat;
+	BackFrame->BytesPerPixel = BytesPerPixel;
+	PixelBuffer = BackFrame->Pixels.GetData();
+	{
+		FScopeLock Lock(&FrontFrameLock);
+		FrontFrame.Reset();
+	}
+	DirtyRects.Reset();
 
 	// Initially clear the texture
 	Clear();
@@ -40,56 +87,73 @@ void UDynamicTexture::Initialize(int32 InWidth, int32 InHeight, FLinearColor InC
 
 void UDynamicTexture::SetPixel(int32 X, int32 Y, FLinearColor Color)
 {
-	// Get the pointer of the specified pixel
-	uint8* Ptr = GetPointerToPixel(X, Y);
-	//UE_LOG(LogTemp, Warning, TEXT("Internal color\tX: %i\tY: %i\tr: %i\tg: %i\tb: %i\ta: %i"), X, Y, static_cast<int>(Color.R * 255), static_cast<int>(Color.G * 255), static_cast<int>(Color.B * 255), static_cast<int>(Color.A * 255));
-	//UE_LOG(LogTemp, Warning, TEXT("Using Buffer of width: %i\theight: %i\tsize: %i"), TextureWidth, TextureHeight, TextureWidth * TextureHeight * DYNAMIC_TEXTURE_BYTES_PER_PIXEL);
-	//UE_LOG(LogTemp, Warning, TEXT("Did initialize texture: %i"), bDidInitialize);
-
-	if (Ptr == NULL || !bDidInitialize) {
+	if (PixelBuffer == nullptr || !bDidInitialize || X < 0 || Y < 0 || X >= TextureWidth || Y >= TextureHeight) {
 		return;
 	}
-	// Set the pixel (note that linear color uses floats between 0..1, but a uint8 ranges from 0..255)
-	SetPixelInternal(Ptr, Color.R * 255, Color.G * 255, Color.B * 255, Color.A * 255);
+
+	DispatchDynamicTexturePixelFormat(PixelFormat, [&](auto Traits)
+	{
+		typedef decltype(Traits) TPixelTraits;
+		*GetPixels<TPixelTraits>(X, Y) = TPixelTraits::Pack(Color);
+	});
+	MarkDirty(X, Y, 1, 1);
 }
 
 void UDynamicTexture::Fill(FLinearColor Color)
 {
-	// Get the base pointer of the pixel buffer
-	uint8* Ptr = PixelBuffer.Get();
+	if (PixelBuffer == nullptr) {
+		return;
+	}
 
-	// Iterate over all pixels
-	for (int i = 0; i < TextureWidth * TextureHeight; ++i)
+	// The buffer is contiguous, so the whole canvas is a single span
+	DispatchDynamicTexturePixelFormat(PixelFormat, [&](auto Traits)
 	{
-		// Set the pixel
-		SetPixelInternal(Ptr, Color.R * 255, Color.G * 255, Color.B * 255, Color.A * 255);
+		typedef decltype(Traits) TPixelTraits;
+		FillPixelSpan<TPixelTraits>(GetPixels<TPixelTraits>(0, 0), TextureWidth * TextureHeight, TPixelTraits::Pack(Color));
+	});
 
-		// Advance to the next pixel
-		Ptr += DYNAMIC_TEXTURE_BYTES_PER_PIXEL;
-	}
+	// The whole canvas changed, so a single full region replaces any partial ones
+	DirtyRects.Reset();
+	MarkDirty(0, 0, TextureWidth, TextureHeight);
 }
 
 void UDynamicTexture::FillRect(int32 X, int32 Y, int32 Width, int32 Height, FLinearColor Color)
 {
-	// Will hold the current pixel
-	uint8* Ptr = NULL;
+	if (PixelBuffer == nullptr) {
+		return;
+	}
 
-	// Loop over the Y and X region
-	for (int y = Y; y < Y + Height; y++)
-	{
-		for (int x = X; x < X + Width; x++)
-		{
-			// Get the current pixel pointer
-			Ptr = GetPointerToPixel(x, y);
+	// Clip the rectangle against the canvas
+	int32 MinX = FMath::Max(X, 0);
+	int32 MinY = FMath::Max(Y, 0);
+	int32 MaxX = FMath::Min(X + Width, TextureWidth);
+	int32 MaxY = FMath::Min(Y + Height, TextureHeight);
+	if (MinX >= MaxX || MinY >= MaxY) {
+		return;
+	}
 
-			// Set the pixel
-			SetPixelInternal(Ptr, Color.R * 255, Color.G * 255, Color.B * 255, Color.A * 255);
-		}
+	// Fill the first row with the packed color, then copy that row down
+	const SIZE_T RowBytes = SIZE_T(MaxX - MinX) * BytesPerPixel;
+	uint8* FirstRow = GetPointerToPixel(MinX, MinY);
+	DispatchDynamicTexturePixelFormat(PixelFormat, [&](auto Traits)
+	{
+		typedef decltype(Traits) TPixelTraits;
+		FillPixelSpan<TPixelTraits>(GetPixels<TPixelTraits>(MinX, MinY), MaxX - MinX, TPixelTraits::Pack(Color));
+	});
+	for (int32 Row = MinY + 1; Row < MaxY; Row++)
+	{
+		FMemory::Memcpy(GetPointerToPixel(MinX, Row), FirstRow, RowBytes);
 	}
+
+	MarkDirty(MinX, MinY, MaxX - MinX, MaxY - MinY);
 }
 
 void UDynamicTexture::DrawLine(int32 X1, int32 Y1, int32 X2, int32 Y2, FLinearColor Color)
 {
+	if (PixelBuffer == nullptr) {
+		return;
+	}
+
 	// Bresenham's line algorithm taken from here: http://members.chello.at/~easyfilter/bresenham.html
 	int X = X1;
 	int Y = Y1;
@@ -98,13 +162,145 @@ void UDynamicTexture::DrawLine(int32 X1, int32 Y1, int32 X2, int32 Y2, FLinearCo
 	int dy = -abs(Y2 - Y1), sy = Y1 < Y2 ? 1 : -1;
 	int err = dx + dy, e2; // error value e_xy
 
-	for (;;)
+	// The whole line is one dirty region, so mark its bounds once instead of every pixel
+	MarkDirty(FMath::Min(X1, X2), FMath::Min(Y1, Y2), dx + 1, -dy + 1);
+
+	DispatchDynamicTexturePixelFormat(PixelFormat, [&](auto Traits)
+	{
+		typedef decltype(Traits) TPixelTraits;
+		const typename TPixelTraits::FPixel Pixel = TPixelTraits::Pack(Color);
+
+		for (;;)
+		{
+			if (X >= 0 && Y >= 0 && X < TextureWidth && Y < TextureHeight) {
+				*GetPixels<TPixelTraits>(X, Y) = Pixel;
+			}
+			if (X == X2 && Y == Y2) break;
+			e2 = 2 * err;
+			if (e2 >= dy) { err += dy; X += sx; } // e_xy+e_x > 0
+			if (e2 <= dx) { err += dx; Y += sy; } // e_xy+e_y < 0
+		}
+	});
+}
+
+void UDynamicTexture::WritePixels(int32 X, int32 Y, int32 Width, int32 Height, const FColor* Pixels, int32 SourceStride)
+{
+	if (Pixels == NULL || !bDidInitialize) {
+		return;
+	}
+
+	// Clip the block against the canvas
+	int32 MinX = FMath::Max(X, 0);
+	int32 MinY = FMath::Max(Y, 0);
+	int32 MaxX = FMath::Min(X + Width, TextureWidth);
+	int32 MaxY = FMath::Min(Y + Height, TextureHeight);
+	if (MinX >= MaxX || MinY >= MaxY) {
+		return;
+	}
+
+	DispatchDynamicTexturePixelFormat(PixelFormat, [&](auto Traits)
+	{
+		typedef decltype(Traits) TPixelTraits;
+		for (int32 Row = MinY; Row < MaxY; Row++)
+		{
+			const FColor* Source = Pixels + (Row - Y) * SourceStride + (MinX - X);
+			if constexpr (TPixelTraits::Format == EDynamicTexturePixelFormat::BGRA8)
+			{
+				// FColor is laid out as BGRA in memory, same as the pixel buffer, so rows copy straight across
+				FMemory::Memcpy(GetPointerToPixel(MinX, Row), Source, (MaxX - MinX) * TPixelTraits::BytesPerPixel);
+			}
+			else
+			{
+				typename TPixelTraits::FPixel* Dest = GetPixels<TPixelTraits>(MinX, Row);
+				for (int32 Column = 0; Column < MaxX - MinX; Column++)
+				{
+					Dest[Column] = TPixelTraits::FromColor(Source[Column]);
+				}
+			}
+		}
+	});
+
+	MarkDirty(MinX, MinY, MaxX - MinX, MaxY - MinY);
+}
+
+void UDynamicTexture::ExecuteDrawList(const FDynamicTextureDrawList& DrawList)
+{
+	if (PixelBuffer == nullptr || !bDidInitialize) {
+		return;
+	}
+
+	DrawList.Execute(PixelBuffer, TextureWidth, TextureHeight, PixelFormat);
+
+	for (const FDynamicTextureDrawCommand& Command : DrawList.GetCommands())
+	{
+		MarkDirty(Command.Bounds.Min.X, Command.Bounds.Min.Y, Command.Bounds.Width(), Command.Bounds.Height());
+	}
+}
+
+void UDynamicTexture::MarkDirty(int32 X, int32 Y, int32 Width, int32 Height)
+{
+	// Clip the rectangle against the canvas
+	FIntRect Rect(FMath::Max(X, 0), FMath::Max(Y, 0), FMath::Min(X + Width, TextureWidth), FMath::Min(Y + Height, TextureHeight));
+	if (Rect.Min.X >= Rect.Max.X || Rect.Min.Y >= Rect.Max.Y) {
+		return;
+	}
+
+	// Grow any region this one overlaps or touches, so neighbouring writes (scanlines,
+	// consecutive SetPixel calls) collapse into a single upload region
+	for (FIntRect& Dirty : DirtyRects)
+	{
+		if (Rect.Min.X <= Dirty.Max.X && Rect.Max.X >= Dirty.Min.X && Rect.Min.Y <= Dirty.Max.Y && Rect.Max.Y >= Dirty.Min.Y)
+		{
+			Dirty.Union(Rect);
+			return;
+		}
+	}
+
+	if (DirtyRects.Num() < MaxDirtyRects)
+	{
+		DirtyRects.Add(Rect);
+		return;
+	}
+
+	// Out of regions, merge into the one that grows the least
+	int32 BestIndex = 0;
+	int64 BestGrowth = MAX_int64;
+	for (int32 i = 0; i < DirtyRects.Num(); i++)
+	{
+		FIntRect Merged = DirtyRects[i];
+		Merged.Union(Rect);
+		int64 Growth = int64(Merged.Width()) * Merged.Height() - int64(DirtyRects[i].Width()) * DirtyRects[i].Height();
+		if (Growth < BestGrowth)
+		{
+			BestGrowth = Growth;
+			BestIndex = i;
+		}
+	}
+	DirtyRects[BestIndex].Union(Rect);
+}
+
+void UDynamicTexture::CoalesceDirtyRects()
+{
+	// Merging can make regions overlap, fold those together so no pixel is uploaded twice
+	bool bMerged = true;
+	while (bMerged)
 	{
-		SetPixel(X, Y, Color);
-		if (X == X2 && Y == Y2) break;
-		e2 = 2 * err;
-		if (e2 >= dy) { err += dy; X += sx; } // e_xy+e_x > 0
-		if (e2 <= dx) { err += dx; Y += sy; } // e_xy+e_y < 0
+		bMerged = false;
+		for (int32 i = 0; i < DirtyRects.Num() && !bMerged; i++)
+		{
+			for (int32 j = i + 1; j < DirtyRects.Num(); j++)
+			{
+				const FIntRect& A = DirtyRects[i];
+				const FIntRect& B = DirtyRects[j];
+				if (A.Min.X < B.Max.X && A.Max.X > B.Min.X && A.Min.Y < B.Max.Y && A.Max.Y > B.Min.Y)
+				{
+					DirtyRects[i].Union(B);
+					DirtyRects.RemoveAtSwap(j);
+					bMerged = true;
+					break;
+				}
+			}
+		}
 	}
 }
 
@@ -119,44 +315,127 @@ UTexture2D* UDynamicTexture::GetTextureResource()
 	return Texture;
 }
 
-void UDynamicTexture::SetPixelInternal(uint8*& Ptr, uint8 Red, uint8 Green, uint8 Blue, uint8 Alpha)
-{
-	// Pixels are stored in BGRA format
-	*Ptr = Blue;
-	*(Ptr + 1) = Green;
-	*(Ptr + 2) = Red;
-	*(Ptr + 3) = Alpha;
-}
-
 uint8* UDynamicTexture::GetPointerToPixel(int32 X, int32 Y)
 {
 	// The calculation of the pointer address of a given pixel is
 	// base + ((x + (y * width)) * bpp)
-	return (PixelBuffer.Get() + ((X + (Y * TextureWidth)) * DYNAMIC_TEXTURE_BYTES_PER_PIXEL));
+	return (PixelBuffer + ((X + (Y * TextureWidth)) * BytesPerPixel));
 }
 
 void UDynamicTexture::UpdateTexture()
 {
-	// Make sure the proxy and the texture is valid
-	if (UpdateTextureRegionProxy.IsValid() && Texture)
+	// Make sure the texture is valid and something was drawn since the last update
+	if (Texture && BackFrame.IsValid() && DirtyRects.Num() > 0)
 	{
-		// Update the texture's regions
-		Texture->UpdateTextureRegions(
-			0,											// Mip index
-			1,											// Number of regions
-			UpdateTextureRegionProxy.Get(),				// Region proxy
-			TextureWidth * DYNAMIC_TEXTURE_BYTES_PER_PIXEL,	// Source data pitch
-			DYNAMIC_TEXTURE_BYTES_PER_PIXEL,			// Bytes per pixel of source data
-			PixelBuffer.Get()							// Buffer of pixels to set
-		);
-		ExternalBuffer = FDynamicTextureBuffer();
-		SIZE_T BufferSize = TextureWidth * TextureHeight * DYNAMIC_TEXTURE_BYTES_PER_PIXEL;
+		CoalesceDirtyRects();
+
+		// The upload keeps its own reference to the frame, so it is never recycled
+		// for drawing while the render thread is still reading from it
+		TSharedPtr<FDynamicTextureFrame, ESPMode::ThreadSafe> UploadFrame = BackFrame;
+		UploadFrame->FrameNumber = ++FrameCounter;
+
+		DispatchDynamicTexturePixelFormat(PixelFormat, [&](auto Traits)
+		{
+			typedef decltype(Traits) TPixelTraits;
+			if constexpr (TPixelTraits::BytesPerPixel == TPixelTraits::UploadBytesPerPixel)
+			{
+				// The render thread reads the regions after this call returns, so they are
+				// heap allocated and released by the cleanup callback once uploaded
+				const int32 NumRegions = DirtyRects.Num();
+				FUpdateTextureRegion2D* Regions = new FUpdateTextureRegion2D[NumRegions];
+				for (int32 i = 0; i < NumRegions; i++)
+				{
+					const FIntRect& Rect = DirtyRects[i];
+					Regions[i] = FUpdateTextureRegion2D(Rect.Min.X, Rect.Min.Y, Rect.Min.X, Rect.Min.Y, Rect.Width(), Rect.Height());
+				}
 
-		//UE_LOG(LogTemp, Warning, TEXT("Pixel Buffer length: %i"), BufferSize);
-		ExternalBuffer.SetPixelBuffer(PixelBuffer.Get(), BufferSize);
+				// Update the texture's regions
+				Texture->UpdateTextureRegions(
+					0,											// Mip index
+					NumRegions,									// Number of regions
+					Regions,									// Dirty regions
+					TextureWidth * TPixelTraits::BytesPerPixel,	// Source data pitch
+					TPixelTraits::BytesPerPixel,				// Bytes per pixel of source data
+					UploadFrame->Pixels.GetData(),				// Buffer of pixels to set
+					[UploadFrame](uint8* SrcData, const FUpdateTextureRegion2D* InRegions) mutable
+					{
+						delete[] InRegions;
+						UploadFrame.Reset();
+					}
+				);
+			}
+			else
+			{
+				// The GPU layout differs from storage, so each dirty region is expanded into
+				// its own tightly packed staging block which the render thread frees
+				for (const FIntRect& Rect : DirtyRects)
+				{
+					const int32 Pitch = Rect.Width() * TPixelTraits::UploadBytesPerPixel;
+					uint8* Staging = new uint8[SIZE_T(Pitch) * Rect.Height()];
+					ConvertDynamicTextureRegionForUpload<TPixelTraits>(PixelBuffer, TextureWidth, Rect, Staging);
+
+					Texture->UpdateTextureRegions(
+						0,
+						1,
+						new FUpdateTextureRegion2D(Rect.Min.X, Rect.Min.Y, 0, 0, Rect.Width(), Rect.Height()),
+						Pitch,
+						TPixelTraits::UploadBytesPerPixel,
+						Staging,
+						[](uint8* SrcData, const FUpdateTextureRegion2D* InRegions)
+						{
+							delete[] SrcData;
+							delete InRegions;
+						}
+					);
+				}
+			}
+		});
+
+		FlipFrames();
 	}
 }
 
+void UDynamicTexture::FlipFrames()
+{
+	// Publish the finished back frame to readers
+	TSharedPtr<FDynamicTextureFrame, ESPMode::ThreadSafe> Published = BackFrame;
+	TSharedPtr<FDynamicTextureFrame, ESPMode::ThreadSafe> Recycled;
+	{
+		FScopeLock Lock(&FrontFrameLock);
+		Recycled = FrontFrame;
+		FrontFrame = Published;
+	}
+
+	// The previous front frame is one frame behind. If nobody else holds it any more it
+	// only needs this frame's dirty regions to catch up, otherwise start a fresh copy.
+	if (Recycled.IsValid() && Recycled.IsUnique() && Recycled->Pixels.Num() == Published->Pixels.Num())
+	{
+		for (const FIntRect& Rect : DirtyRects)
+		{
+			const SIZE_T RowBytes = Rect.Width() * BytesPerPixel;
+			for (int32 Row = Rect.Min.Y; Row < Rect.Max.Y; Row++)
+			{
+				const SIZE_T Offset = (Rect.Min.X + Row * TextureWidth) * BytesPerPixel;
+				FMemory::Memcpy(Recycled->Pixels.GetData() + Offset, Published->Pixels.GetData() + Offset, RowBytes);
+			}
+		}
+	}
+	else
+	{
+		Recycled = MakeShared<FDynamicTextureFrame, ESPMode::ThreadSafe>(*Published);
+	}
+
+	BackFrame = Recycled;
+	PixelBuffer = BackFrame->Pixels.GetData();
+	DirtyRects.Reset();
+}
+
+FDynamicTextureSnapshot UDynamicTexture::GetSnapshot()
+{
+	FScopeLock Lock(&FrontFrameLock);
+	return FrontFrame;
+}
+
 int32 UDynamicTexture::GetWidth()
 {
 	return TextureWidth;
@@ -165,4 +444,9 @@ int32 UDynamicTexture::GetWidth()
 int32 UDynamicTexture::GetHeight()
 {
 	return TextureHeight;
+}
+
+EDynamicTexturePixelFormat UDynamicTexture::GetPixelFormat()
+{
+	return PixelFormat;
 }
\ No newline at end of file
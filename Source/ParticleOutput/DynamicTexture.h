@@ -5,32 +5,35 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "RHI.h"
-#include "Templates/UniquePtr.h"
+#include "Templates/SharedPointer.h"
+#include "HAL/CriticalSection.h"
 #include "Engine/Texture.h"
+#include "DynamicTextureDrawList.h"
+#include "DynamicTexturePixelFormats.h"
 #include "DynamicTexture.generated.h"
 
-USTRUCT() 
-struct FDynamicTextureBuffer
+/*
+	A completed frame of the dynamic texture. Frames handed out through
+	UDynamicTexture::GetSnapshot are never written to again while anyone
+	still holds a reference, so they can be read from any thread.
+*/
+struct FDynamicTextureFrame
 {
-	GENERATED_BODY()
+	// Raw pixel data in the texture's storage format, Width * Height * BytesPerPixel bytes
+	TArray<uint8> Pixels;
 
-	UPROPERTY()
-	TArray<uint8> PixelBuffer;
+	int32 Width = 0;
+	int32 Height = 0;
 
-	void SetPixelBuffer(uint8_t * Value, int32 bufferCount)
-	{
-		PixelBuffer.Empty();
-		for (int i = 0; i < bufferCount; i++) {
-			PixelBuffer.Add(Value[i]);
-		}
-	}
+	EDynamicTexturePixelFormat Format = EDynamicTexturePixelFormat::BGRA8;
+	int32 BytesPerPixel = 4;
 
-	FDynamicTextureBuffer()
-	{
-		PixelBuffer.Init(0, 0);
-	}
+	// Increments with every UpdateTexture that published new pixels
+	uint64 FrameNumber = 0;
 };
 
+typedef TSharedPtr<const FDynamicTextureFrame, ESPMode::ThreadSafe> FDynamicTextureSnapshot;
+
 /*
 	This implements a fast dynamic texture without the use of the
 	UE4 Slate canvas features, which are way to slow for real-time
@@ -43,9 +46,10 @@ class PARTICLEOUTPUT_API UDynamicTexture : public UObject
 	GENERATED_BODY()
 
 public:
-	// Initializes the dynamic texture with given dimensions
+	// Initializes the dynamic texture with given dimensions. The pixel format decides the
+	// CPU storage and the texture created for it, see DynamicTexturePixelFormats.h
 	UFUNCTION(BlueprintCallable, Category = "Dynamic Texture")
-		void Initialize(int32 InWidth, int32 InHeight, FLinearColor InClearColor, TextureFilter FilterMethod = TextureFilter::TF_Nearest);
+		void Initialize(int32 InWidth, int32 InHeight, FLinearColor InClearColor, TextureFilter FilterMethod = TextureFilter::TF_Nearest, EDynamicTexturePixelFormat InPixelFormat = EDynamicTexturePixelFormat::BGRA8);
 
 	// Sets a specified pixel to a color
 	UFUNCTION(BlueprintCallable, Category = "Dynamic Texture")
@@ -63,6 +67,17 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Dynamic Texture")
 		void DrawLine(int32 X1, int32 Y1, int32 X2, int32 Y2, FLinearColor Color);
 
+	// Copies a block of BGRA pixels into the texture at the given position, converting
+	// them to the texture's format. SourceStride is the number of pixels per row in the source block
+	void WritePixels(int32 X, int32 Y, int32 Width, int32 Height, const FColor* Pixels, int32 SourceStride);
+
+	// Rasterizes all commands recorded in a draw list in one pass
+	void ExecuteDrawList(const FDynamicTextureDrawList& DrawList);
+
+	// Marks a rectangle of the texture as modified, so the next UpdateTexture uploads it
+	UFUNCTION(BlueprintCallable, Category = "Dynamic Texture")
+		void MarkDirty(int32 X, int32 Y, int32 Width, int32 Height);
+
 	// Clears the canvas (same as filling with the clear color)
 	UFUNCTION(BlueprintCallable, Category = "Dynamic Texture")
 		void Clear();
@@ -73,7 +88,8 @@ public:
 
 	// Needs to be called at the end of each drawing operation to update the texture
 	// You can also call this at the end of multiple drawing operations, so the UTexture
-	// does not get updated more than needed.
+	// does not get updated more than needed. Only the regions touched since the last
+	// update are uploaded.
 	UFUNCTION(BlueprintCallable, Category = "Dynamic Texture")
 		void UpdateTexture();
 
@@ -85,20 +101,34 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Dynamic Texture")
 		int32 GetHeight();
 
-	// Unique pointer to the raw pixel data of the texture
-	UPROPERTY(VisibleAnywhere, Category = "Dynamic Texture")
-	FDynamicTextureBuffer ExternalBuffer;
+	// Returns the storage format this texture was initialized with
+	UFUNCTION(BlueprintPure, Category = "Dynamic Texture")
+		EDynamicTexturePixelFormat GetPixelFormat();
+
+	// Returns the last frame published by UpdateTexture, without copying it.
+	// Safe to call from any thread; invalid until the first UpdateTexture.
+	FDynamicTextureSnapshot GetSnapshot();
 
 	UPROPERTY(VisibleAnywhere, Category = "Dynanmic Texture")
 	bool bDidInitialize;
 
 private:
-	// Internal function to set a pixel in the image
-	void SetPixelInternal(uint8*& Ptr, uint8 Red, uint8 Green, uint8 Blue, uint8 Alpha);
-
 	// Internal function to return the pointer pointing to the specified pixel
 	uint8* GetPointerToPixel(int32 X, int32 Y);
 
+	// Internal function to return the specified pixel typed for the texture's format
+	template<typename TPixelTraits>
+	typename TPixelTraits::FPixel* GetPixels(int32 X, int32 Y)
+	{
+		return reinterpret_cast<typename TPixelTraits::FPixel*>(GetPointerToPixel(X, Y));
+	}
+
+	// Internal function to merge overlapping dirty regions before an upload
+	void CoalesceDirtyRects();
+
+	// Internal function to publish the back frame and pick the frame to draw into next
+	void FlipFrames();
+
 private:
 	// Reference to the UTexture2D* were drawing to
 	UPROPERTY()
@@ -111,12 +141,30 @@ private:
 	// The clear color of the canvas
 	FLinearColor ClearColor;
 
-	// Unique pointer to the proxy used to update the texture region (not really using regions,
-	// it's one "big" region)
-	TUniquePtr<FUpdateTextureRegion2D> UpdateTextureRegionProxy;
+	// Storage format of the pixel buffer and its size per pixel
+	EDynamicTexturePixelFormat PixelFormat = EDynamicTexturePixelFormat::BGRA8;
+	int32 BytesPerPixel = 4;
+
+	// Regions modified since the last UpdateTexture, merged as they are added
+	TArray<FIntRect> DirtyRects;
+
+	// Upper bound on separate dirty regions, beyond this they get merged together
+	static constexpr int32 MaxDirtyRects = 8;
+
+	// Frame being drawn into. Only touched on the game thread
+	TSharedPtr<FDynamicTextureFrame, ESPMode::ThreadSafe> BackFrame;
+
+	// Last published frame, shared with readers and pending render thread uploads
+	TSharedPtr<FDynamicTextureFrame, ESPMode::ThreadSafe> FrontFrame;
+
+	// Guards swapping FrontFrame against readers on other threads
+	FCriticalSection FrontFrameLock;
+
+	// Raw pixel data of the back frame
+	uint8* PixelBuffer = nullptr;
 
-	// Unique pointer to the raw pixel data of the texture
-	TUniquePtr<uint8[]> PixelBuffer;
+	// Number of frames published so far
+	uint64 FrameCounter = 0;
 
 
 };
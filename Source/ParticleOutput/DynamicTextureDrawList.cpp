@@ -0,0 +1,522 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DynamicTextureDrawList.h"
+#include "Async/ParallelFor.h"
+
+// Height of the horizontal bands the canvas is split into for parallel rasterization
+#define DRAW_LIST_BAND_HEIGHT 32
+
+// Below this many commands the bands are rasterized on the calling thread
+#define DRAW_LIST_PARALLEL_THRESHOLD 64
+
+// A color packed once per command, with its alpha scaled to 0..256 for blending
+template<typename TPixelTraits>
+struct TPackedDrawColor
+{
+	typename TPixelTraits::FPixel Pixel;
+	uint32 Alpha;
+};
+
+template<typename TPixelTraits>
+static TPackedDrawColor<TPixelTraits> PackDrawColor(const FLinearColor& Color)
+{
+	const uint32 Alpha = uint32(FMath::Clamp(Color.A, 0.0f, 1.0f) * 255);
+	return { TPixelTraits::Pack(Color), Alpha + (Alpha >> 7) };
+}
+
+// Multiplies two packed pixels channel by channel
+static FORCEINLINE uint32 ModulatePixel(uint32 A, uint32 B)
+{
+	uint32 Result = 0;
+	for (int32 Shift = 0; Shift < 32; Shift += 8)
+	{
+		const uint32 Channel = ((A >> Shift) & 0xFF) * ((B >> Shift) & 0xFF) + 255;
+		Result |= ((Channel >> 8) & 0xFF) << Shift;
+	}
+	return Result;
+}
+
+// The rows of the canvas one worker rasterizes into
+template<typename TPixelTraits>
+struct TDrawBand
+{
+	typedef typename TPixelTraits::FPixel FPixel;
+	typedef TPackedDrawColor<TPixelTraits> FPackedDrawColor;
+
+	FPixel* Pixels;
+	int32 Width;
+	int32 MinY;
+	int32 MaxY;
+
+	FORCEINLINE bool Contains(int32 X, int32 Y) const
+	{
+		return X >= 0 && X < Width && Y >= MinY && Y < MaxY;
+	}
+
+	// Blends a single pixel, Coverage scales the color alpha (0..256)
+	FORCEINLINE void Plot(int32 X, int32 Y, const FPackedDrawColor& Color, uint32 Coverage = 256)
+	{
+		if (!Contains(X, Y)) {
+			return;
+		}
+		FPixel& Dst = Pixels[X + Y * Width];
+		const uint32 Alpha = (Color.Alpha * Coverage) >> 8;
+		Dst = Alpha >= 256 ? Color.Pixel : TPixelTraits::Blend(Dst, Color.Pixel, Alpha);
+	}
+
+	// Blends a horizontal run of pixels [X0, X1] on row Y
+	void Span(int32 X0, int32 X1, int32 Y, const FPackedDrawColor& Color)
+	{
+		if (Y < MinY || Y >= MaxY) {
+			return;
+		}
+		X0 = FMath::Max(X0, 0);
+		X1 = FMath::Min(X1, Width - 1);
+		if (X0 > X1) {
+			return;
+		}
+
+		FPixel* Row = Pixels + Y * Width;
+		if (Color.Alpha >= 256)
+		{
+			for (int32 X = X0; X <= X1; X++)
+			{
+				Row[X] = Color.Pixel;
+			}
+			return;
+		}
+
+		if constexpr (TPixelTraits::Format == EDynamicTexturePixelFormat::BGRA8)
+		{
+			// The source terms are the same for every pixel, so only the destination is multiplied
+			const uint32 InvAlpha = 256 - Color.Alpha;
+			const uint32 SrcRB = (Color.Pixel & 0x00FF00FF) * Color.Alpha;
+			const uint32 SrcAG = ((Color.Pixel >> 8) & 0x00FF00FF) * Color.Alpha;
+			for (int32 X = X0; X <= X1; X++)
+			{
+				const uint32 Dst = Row[X];
+				const uint32 RB = ((SrcRB + (Dst & 0x00FF00FF) * InvAlpha) >> 8) & 0x00FF00FF;
+				const uint32 AG = (SrcAG + ((Dst >> 8) & 0x00FF00FF) * InvAlpha) & 0xFF00FF00;
+				Row[X] = RB | AG;
+			}
+		}
+		else
+		{
+			for (int32 X = X0; X <= X1; X++)
+			{
+				Row[X] = TPixelTraits::Blend(Row[X], Color.Pixel, Color.Alpha);
+			}
+		}
+	}
+};
+
+template<typename TPixelTraits>
+static void RasterizeLine(const FDynamicTextureDrawCommand& Command, const TPackedDrawColor<TPixelTraits>& Color, TDrawBand<TPixelTraits>& Band)
+{
+	// Bresenham's line, with each pixel's minor coordinate computed straight from its step along
+	// the major axis. The same pixels come out in every band, and a band only steps over its own rows
+	const int32 X0 = int32(Command.P0.X);
+	const int32 Y0 = int32(Command.P0.Y);
+	const int32 X1 = int32(Command.P1.X);
+	const int32 Y1 = int32(Command.P1.Y);
+
+	const int64 dx = FMath::Abs(X1 - X0), sx = X0 < X1 ? 1 : -1;
+	const int64 dy = FMath::Abs(Y1 - Y0), sy = Y0 < Y1 ? 1 : -1;
+
+	// Offsets from Y0 along the line's vertical direction that fall inside the band
+	const int64 RowLo = sy > 0 ? Band.MinY - Y0 : Y0 - (Band.MaxY - 1);
+	const int64 RowHi = sy > 0 ? Band.MaxY - 1 - Y0 : Y0 - Band.MinY;
+
+	if (dx >= dy) {
+		// One pixel per column, at row offset (2 * Step * dy + dx) / (2 * dx). That offset never
+		// decreases, so the columns in the band are one range, solved for directly
+		if (RowHi < 0 || (dy == 0 && RowLo > 0)) {
+			return;
+		}
+		const int64 First = RowLo <= 0 ? 0 : FMath::DivideAndRoundUp(2 * dx * RowLo - dx, 2 * dy);
+		const int64 Last = dy == 0 ? dx : FMath::Min(dx, FMath::DivideAndRoundUp(2 * dx * (RowHi + 1) - dx, 2 * dy) - 1);
+		// A single point has no run, its row offset is 0 either way
+		const int64 Run = FMath::Max<int64>(dx, 1);
+		for (int64 Step = First; Step <= Last; Step++)
+		{
+			Band.Plot(X0 + int32(sx * Step), Y0 + int32(sy * ((2 * Step * dy + dx) / (2 * Run))), Color);
+		}
+	}
+	else {
+		// One pixel per row, so the band's rows are the steps
+		const int64 First = FMath::Max<int64>(RowLo, 0);
+		const int64 Last = FMath::Min(RowHi, dy);
+		for (int64 Step = First; Step <= Last; Step++)
+		{
+			Band.Plot(X0 + int32(sx * ((2 * Step * dx + dy) / (2 * dy))), Y0 + int32(sy * Step), Color);
+		}
+	}
+}
+
+template<typename TPixelTraits>
+static void RasterizeSmoothLine(const FDynamicTextureDrawCommand& Command, const TPackedDrawColor<TPixelTraits>& Color, TDrawBand<TPixelTraits>& Band)
+{
+	// Xiaolin Wu's line algorithm, coverage is split between the two pixels straddling the line
+	float X0 = Command.P0.X, Y0 = Command.P0.Y;
+	float X1 = Command.P1.X, Y1 = Command.P1.Y;
+
+	const bool bSteep = FMath::Abs(Y1 - Y0) > FMath::Abs(X1 - X0);
+	if (bSteep) {
+		Swap(X0, Y0);
+		Swap(X1, Y1);
+	}
+	if (X0 > X1) {
+		Swap(X0, X1);
+		Swap(Y0, Y1);
+	}
+
+	const float Gradient = X1 - X0 == 0.0f ? 1.0f : (Y1 - Y0) / (X1 - X0);
+
+	auto PlotCovered = [&](int32 X, int32 Y, float Coverage)
+	{
+		const uint32 Scaled = uint32(FMath::Clamp(Coverage, 0.0f, 1.0f) * 256.0f);
+		if (bSteep) {
+			Band.Plot(Y, X, Color, Scaled);
+		}
+		else {
+			Band.Plot(X, Y, Color, Scaled);
+		}
+	};
+
+	// First endpoint
+	float XEnd = FMath::RoundToFloat(X0);
+	float YEnd = Y0 + Gradient * (XEnd - X0);
+	float XGap = 1.0f - FMath::Frac(X0 + 0.5f);
+	const int32 XPixel1 = int32(XEnd);
+	int32 YPixel = FMath::FloorToInt(YEnd);
+	PlotCovered(XPixel1, YPixel, (1.0f - FMath::Frac(YEnd)) * XGap);
+	PlotCovered(XPixel1, YPixel + 1, FMath::Frac(YEnd) * XGap);
+	const float InterY = YEnd + Gradient;
+
+	// Second endpoint
+	XEnd = FMath::RoundToFloat(X1);
+	YEnd = Y1 + Gradient * (XEnd - X1);
+	XGap = FMath::Frac(X1 + 0.5f);
+	const int32 XPixel2 = int32(XEnd);
+	YPixel = FMath::FloorToInt(YEnd);
+	PlotCovered(XPixel2, YPixel, (1.0f - FMath::Frac(YEnd)) * XGap);
+	PlotCovered(XPixel2, YPixel + 1, FMath::Frac(YEnd) * XGap);
+
+	// Everything in between, clipped to the steps that can reach the band's rows. Each step's
+	// position is computed from the first endpoint, so every band plots the same pixels
+	int32 FirstStep = XPixel1 + 1;
+	int32 LastStep = XPixel2 - 1;
+	if (bSteep) {
+		FirstStep = FMath::Max(FirstStep, Band.MinY);
+		LastStep = FMath::Min(LastStep, Band.MaxY - 1);
+	}
+	else if (Gradient != 0.0f) {
+		// Rows Y and Y + 1 are plotted, so InterY has to lie in [MinY - 1, MaxY). One step of slack
+		// on either side covers rounding
+		const float StepA = XPixel1 + 1 + (Band.MinY - 1 - InterY) / Gradient;
+		const float StepB = XPixel1 + 1 + (Band.MaxY - InterY) / Gradient;
+		FirstStep = FMath::Max(FirstStep, FMath::FloorToInt(FMath::Min(StepA, StepB)) - 1);
+		LastStep = FMath::Min(LastStep, FMath::CeilToInt(FMath::Max(StepA, StepB)) + 1);
+	}
+	else if (InterY < Band.MinY - 1 || InterY >= Band.MaxY) {
+		return;
+	}
+
+	for (int32 X = FirstStep; X <= LastStep; X++)
+	{
+		const float Y = InterY + Gradient * (X - XPixel1 - 1);
+		const int32 Row = FMath::FloorToInt(Y);
+		PlotCovered(X, Row, 1.0f - FMath::Frac(Y));
+		PlotCovered(X, Row + 1, FMath::Frac(Y));
+	}
+}
+
+template<typename TPixelTraits>
+static void RasterizeCircle(const FDynamicTextureDrawCommand& Command, const TPackedDrawColor<TPixelTraits>& Color, TDrawBand<TPixelTraits>& Band)
+{
+	// The midpoint circle's pixels, found row by row so a band only visits its own rows and each
+	// pixel is blended once. Along the steep octants the outline has one pixel per row at
+	// X(D) = round(sqrt(R^2 - D^2)), D rows from the center. The flat octants put a run of pixels
+	// on row D, at every Y whose X(Y) is D
+	const int32 CenterX = FMath::RoundToInt(Command.P0.X);
+	const int32 CenterY = FMath::RoundToInt(Command.P0.Y);
+	const int32 Radius = FMath::RoundToInt(Command.Radius);
+	const double RadiusSquared = double(Radius) * Radius;
+
+	const int32 MinY = FMath::Max(CenterY - Radius, Band.MinY);
+	const int32 MaxY = FMath::Min(CenterY + Radius + 1, Band.MaxY);
+	for (int32 Y = MinY; Y < MaxY; Y++)
+	{
+		const int32 D = FMath::Abs(Y - CenterY);
+
+		// Steep octants, while the outline is still further out than D
+		const int32 SteepX = FMath::RoundToInt(FMath::Sqrt(FMath::Max(RadiusSquared - double(D) * D, 0.0)));
+		if (SteepX > D) {
+			Band.Plot(CenterX - SteepX, Y, Color);
+			Band.Plot(CenterX + SteepX, Y, Color);
+		}
+
+		// Flat octants: X(Y') rounds to D when R^2 - (D + 0.5)^2 < Y'^2 <= R^2 - (D - 0.5)^2, up to Y' = D
+		const double Inner = RadiusSquared - FMath::Square(D + 0.5);
+		const double Outer = RadiusSquared - FMath::Square(FMath::Max(D - 0.5, 0.0));
+		if (Outer < 0.0) {
+			continue;
+		}
+		const int32 FlatMin = Inner < 0.0 ? 0 : FMath::FloorToInt(FMath::Sqrt(Inner)) + 1;
+		const int32 FlatMax = FMath::Min(FMath::FloorToInt(FMath::Sqrt(Outer)), D);
+		if (FlatMin > FlatMax) {
+			continue;
+		}
+		// The center column belongs to both runs, so the left one stops short of it
+		Band.Span(CenterX - FlatMax, CenterX - FMath::Max(FlatMin, 1), Y, Color);
+		Band.Span(CenterX + FlatMin, CenterX + FlatMax, Y, Color);
+	}
+}
+
+template<typename TPixelTraits>
+static void RasterizeFilledCircle(const FDynamicTextureDrawCommand& Command, const TPackedDrawColor<TPixelTraits>& Color, TDrawBand<TPixelTraits>& Band)
+{
+	// One span per row, covering the pixels whose centers are inside the disc
+	const int32 MinY = FMath::Max(Command.Bounds.Min.Y, Band.MinY);
+	const int32 MaxY = FMath::Min(Command.Bounds.Max.Y, Band.MaxY);
+	const float RadiusSquared = Command.Radius * Command.Radius;
+
+	for (int32 Y = MinY; Y < MaxY; Y++)
+	{
+		const float DY = (Y + 0.5f) - Command.P0.Y;
+		const float HalfWidthSquared = RadiusSquared - DY * DY;
+		if (HalfWidthSquared < 0.0f) {
+			continue;
+		}
+		const float HalfWidth = FMath::Sqrt(HalfWidthSquared);
+		Band.Span(FMath::CeilToInt(Command.P0.X - HalfWidth - 0.5f), FMath::FloorToInt(Command.P0.X + HalfWidth - 0.5f), Y, Color);
+	}
+}
+
+template<typename TPixelTraits>
+static void RasterizeTriangle(const FDynamicTextureDrawCommand& Command, const TPackedDrawColor<TPixelTraits>& Color, TDrawBand<TPixelTraits>& Band)
+{
+	// Intersect each pixel row's center line with the three edges and fill between
+	const FVector2f Vertices[3] = { Command.P0, Command.P1, Command.P2 };
+	const int32 MinY = FMath::Max(Command.Bounds.Min.Y, Band.MinY);
+	const int32 MaxY = FMath::Min(Command.Bounds.Max.Y, Band.MaxY);
+
+	for (int32 Y = MinY; Y < MaxY; Y++)
+	{
+		const float CenterY = Y + 0.5f;
+		float Left = MAX_flt;
+		float Right = -MAX_flt;
+		for (int32 Edge = 0; Edge < 3; Edge++)
+		{
+			const FVector2f& A = Vertices[Edge];
+			const FVector2f& B = Vertices[(Edge + 1) % 3];
+			if ((CenterY < A.Y) == (CenterY < B.Y)) {
+				continue;
+			}
+			const float X = A.X + (CenterY - A.Y) * (B.X - A.X) / (B.Y - A.Y);
+			Left = FMath::Min(Left, X);
+			Right = FMath::Max(Right, X);
+		}
+		if (Left <= Right) {
+			Band.Span(FMath::CeilToInt(Left - 0.5f), FMath::FloorToInt(Right - 0.5f), Y, Color);
+		}
+	}
+}
+
+void FDynamicTextureDrawList::AddLine(int32 X1, int32 Y1, int32 X2, int32 Y2, FLinearColor Color)
+{
+	FDynamicTextureDrawCommand& Command = Commands.AddDefaulted_GetRef();
+	Command.Type = EDynamicTextureDrawType::Line;
+	Command.P0 = FVector2f(X1, Y1);
+	Command.P1 = FVector2f(X2, Y2);
+	Command.Color = Color;
+	Command.Bounds = FIntRect(FMath::Min(X1, X2), FMath::Min(Y1, Y2), FMath::Max(X1, X2) + 1, FMath::Max(Y1, Y2) + 1);
+}
+
+void FDynamicTextureDrawList::AddSmoothLine(float X1, float Y1, float X2, float Y2, FLinearColor Color)
+{
+	FDynamicTextureDrawCommand& Command = Commands.AddDefaulted_GetRef();
+	Command.Type = EDynamicTextureDrawType::SmoothLine;
+	Command.P0 = FVector2f(X1, Y1);
+	Command.P1 = FVector2f(X2, Y2);
+	Command.Color = Color;
+	// Wu lines spill one pixel past the endpoints on the minor axis
+	Command.Bounds = FIntRect(
+		FMath::FloorToInt(FMath::Min(X1, X2)) - 1, FMath::FloorToInt(FMath::Min(Y1, Y2)) - 1,
+		FMath::CeilToInt(FMath::Max(X1, X2)) + 2, FMath::CeilToInt(FMath::Max(Y1, Y2)) + 2);
+}
+
+void FDynamicTextureDrawList::AddCircle(float CenterX, float CenterY, float Radius, FLinearColor Color, bool bFilled)
+{
+	FDynamicTextureDrawCommand& Command = Commands.AddDefaulted_GetRef();
+	Command.Type = bFilled ? EDynamicTextureDrawType::FilledCircle : EDynamicTextureDrawType::Circle;
+	Command.P0 = FVector2f(CenterX, CenterY);
+	Command.Radius = FMath::Abs(Radius);
+	Command.Color = Color;
+	Command.Bounds = FIntRect(
+		FMath::FloorToInt(CenterX - Command.Radius) - 1, FMath::FloorToInt(CenterY - Command.Radius) - 1,
+		FMath::CeilToInt(CenterX + Command.Radius) + 2, FMath::CeilToInt(CenterY + Command.Radius) + 2);
+}
+
+void FDynamicTextureDrawList::AddTriangle(FVector2f A, FVector2f B, FVector2f C, FLinearColor Color)
+{
+	FDynamicTextureDrawCommand& Command = Commands.AddDefaulted_GetRef();
+	Command.Type = EDynamicTextureDrawType::FilledTriangle;
+	Command.P0 = A;
+	Command.P1 = B;
+	Command.P2 = C;
+	Command.Color = Color;
+	Command.Bounds = FIntRect(
+		FMath::FloorToInt(FMath::Min3(A.X, B.X, C.X)), FMath::FloorToInt(FMath::Min3(A.Y, B.Y, C.Y)),
+		FMath::CeilToInt(FMath::Max3(A.X, B.X, C.X)) + 1, FMath::CeilToInt(FMath::Max3(A.Y, B.Y, C.Y)) + 1);
+}
+
+int32 FDynamicTextureDrawList::RegisterSprite(const FColor* Pixels, int32 Width, int32 Height)
+{
+	if (Pixels == nullptr || Width <= 0 || Height <= 0) {
+		return INDEX_NONE;
+	}
+
+	FSprite& Sprite = Sprites.AddDefaulted_GetRef();
+	Sprite.Pixels.Append(Pixels, Width * Height);
+	Sprite.Width = Width;
+	Sprite.Height = Height;
+	return Sprites.Num() - 1;
+}
+
+void FDynamicTextureDrawList::AddSprite(int32 SpriteIndex, int32 X, int32 Y, FLinearColor Tint)
+{
+	if (!Sprites.IsValidIndex(SpriteIndex)) {
+		return;
+	}
+
+	const FSprite& Sprite = Sprites[SpriteIndex];
+	FDynamicTextureDrawCommand& Command = Commands.AddDefaulted_GetRef();
+	Command.Type = EDynamicTextureDrawType::Sprite;
+	Command.P0 = FVector2f(X, Y);
+	Command.Color = Tint;
+	Command.SpriteIndex = SpriteIndex;
+	Command.Bounds = FIntRect(X, Y, X + Sprite.Width, Y + Sprite.Height);
+}
+
+void FDynamicTextureDrawList::Reset()
+{
+	Commands.Reset();
+}
+
+void FDynamicTextureDrawList::Empty()
+{
+	Commands.Empty();
+	Sprites.Empty();
+}
+
+void FDynamicTextureDrawList::Execute(uint8* Pixels, int32 Width, int32 Height, EDynamicTexturePixelFormat Format) const
+{
+	DispatchDynamicTexturePixelFormat(Format, [&](auto Traits)
+	{
+		ExecuteForFormat<decltype(Traits)>(Pixels, Width, Height);
+	});
+}
+
+template<typename TPixelTraits>
+void FDynamicTextureDrawList::ExecuteForFormat(uint8* Pixels, int32 Width, int32 Height) const
+{
+	typedef typename TPixelTraits::FPixel FPixel;
+
+	if (Pixels == nullptr || Width <= 0 || Height <= 0 || Commands.Num() == 0) {
+		return;
+	}
+
+	// Pack every color once and bin each command into the bands it overlaps
+	const int32 NumBands = FMath::DivideAndRoundUp(Height, DRAW_LIST_BAND_HEIGHT);
+	TArray<TPackedDrawColor<TPixelTraits>> PackedColors;
+	PackedColors.SetNumUninitialized(Commands.Num());
+	TArray<TArray<int32>> BandCommands;
+	BandCommands.SetNum(NumBands);
+
+	for (int32 i = 0; i < Commands.Num(); i++)
+	{
+		const FDynamicTextureDrawCommand& Command = Commands[i];
+		PackedColors[i] = PackDrawColor<TPixelTraits>(Command.Color);
+
+		const FIntRect& Bounds = Command.Bounds;
+		if (Bounds.Max.X <= 0 || Bounds.Min.X >= Width || Bounds.Max.Y <= 0 || Bounds.Min.Y >= Height) {
+			continue;
+		}
+		const int32 FirstBand = FMath::Max(Bounds.Min.Y, 0) / DRAW_LIST_BAND_HEIGHT;
+		const int32 LastBand = (FMath::Min(Bounds.Max.Y, Height) - 1) / DRAW_LIST_BAND_HEIGHT;
+		for (int32 Band = FirstBand; Band <= LastBand; Band++)
+		{
+			BandCommands[Band].Add(i);
+		}
+	}
+
+	// Bands never share rows, so they rasterize independently
+	ParallelFor(NumBands, [&](int32 BandIndex)
+	{
+		TDrawBand<TPixelTraits> Band;
+		Band.Pixels = reinterpret_cast<FPixel*>(Pixels);
+		Band.Width = Width;
+		Band.MinY = BandIndex * DRAW_LIST_BAND_HEIGHT;
+		Band.MaxY = FMath::Min(Band.MinY + DRAW_LIST_BAND_HEIGHT, Height);
+
+		for (int32 CommandIndex : BandCommands[BandIndex])
+		{
+			const FDynamicTextureDrawCommand& Command = Commands[CommandIndex];
+			const TPackedDrawColor<TPixelTraits>& Color = PackedColors[CommandIndex];
+
+			switch (Command.Type)
+			{
+			case EDynamicTextureDrawType::Line:
+				RasterizeLine(Command, Color, Band);
+				break;
+			case EDynamicTextureDrawType::SmoothLine:
+				RasterizeSmoothLine(Command, Color, Band);
+				break;
+			case EDynamicTextureDrawType::Circle:
+				RasterizeCircle(Command, Color, Band);
+				break;
+			case EDynamicTextureDrawType::FilledCircle:
+				RasterizeFilledCircle(Command, Color, Band);
+				break;
+			case EDynamicTextureDrawType::FilledTriangle:
+				RasterizeTriangle(Command, Color, Band);
+				break;
+			case EDynamicTextureDrawType::Sprite:
+			{
+				const FSprite& Sprite = Sprites[Command.SpriteIndex];
+				const int32 OriginX = int32(Command.P0.X);
+				const int32 OriginY = int32(Command.P0.Y);
+				const int32 MinX = FMath::Max(OriginX, 0);
+				const int32 MaxX = FMath::Min(OriginX + Sprite.Width, Width);
+				const int32 MinY = FMath::Max(OriginY, Band.MinY);
+				const int32 MaxY = FMath::Min(OriginY + Sprite.Height, Band.MaxY);
+				// The tint is applied to the BGRA texel before it is converted to the canvas format
+				const uint32 Tint = FDynamicTexturePixelBGRA8::Pack(Command.Color);
+				const bool bTinted = Tint != 0xFFFFFFFF;
+
+				for (int32 Y = MinY; Y < MaxY; Y++)
+				{
+					const FColor* Source = Sprite.Pixels.GetData() + (Y - OriginY) * Sprite.Width;
+					FPixel* Row = Band.Pixels + Y * Width;
+					for (int32 X = MinX; X < MaxX; X++)
+					{
+						FColor Texel = Source[X - OriginX];
+						if (bTinted) {
+							Texel.DWColor() = ModulatePixel(Texel.DWColor(), Tint);
+						}
+						const uint32 Alpha = Texel.A;
+						if (Alpha == 0) {
+							continue;
+						}
+						const FPixel Src = TPixelTraits::FromColor(Texel);
+						Row[X] = Alpha == 255 ? Src : TPixelTraits::Blend(Row[X], Src, Alpha + (Alpha >> 7));
+					}
+				}
+				break;
+			}
+			}
+		}
+	}, Commands.Num() < DRAW_LIST_PARALLEL_THRESHOLD);
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicTexturePixelFormats.h"
+
+// Primitive types a draw list can record
+enum class EDynamicTextureDrawType : uint8
+{
+	Line,
+	SmoothLine,
+	Circle,
+	FilledCircle,
+	FilledTriangle,
+	Sprite
+};
+
+// A single recorded primitive. Unused fields are left at their defaults.
+struct FDynamicTextureDrawCommand
+{
+	EDynamicTextureDrawType Type = EDynamicTextureDrawType::Line;
+
+	// Line endpoints, circle center, triangle vertices or sprite position
+	FVector2f P0 = FVector2f::ZeroVector;
+	FVector2f P1 = FVector2f::ZeroVector;
+	FVector2f P2 = FVector2f::ZeroVector;
+
+	float Radius = 0.0f;
+
+	// Draw color, or the tint multiplied into a sprite. Alpha blends with the canvas.
+	FLinearColor Color = FLinearColor::White;
+
+	int32 SpriteIndex = INDEX_NONE;
+
+	// Pixels the primitive can touch, before clipping against the canvas
+	FIntRect Bounds;
+};
+
+/*
+	Records 2D primitives so they can be rasterized into a UDynamicTexture in
+	one pass. Execution splits the canvas into horizontal bands which are
+	rasterized in parallel; each band draws its commands in recording order,
+	so overlapping primitives blend exactly as if drawn one after another.
+*/
+class PARTICLEOUTPUT_API FDynamicTextureDrawList
+{
+public:
+	// Records an aliased (Bresenham) line between two pixels
+	void AddLine(int32 X1, int32 Y1, int32 X2, int32 Y2, FLinearColor Color);
+
+	// Records an anti-aliased (Xiaolin Wu) line between two sub-pixel positions
+	void AddSmoothLine(float X1, float Y1, float X2, float Y2, FLinearColor Color);
+
+	// Records a circle outline, or a filled disc if bFilled is set
+	void AddCircle(float CenterX, float CenterY, float Radius, FLinearColor Color, bool bFilled);
+
+	// Records a filled triangle, pixels are covered when their center is inside
+	void AddTriangle(FVector2f A, FVector2f B, FVector2f C, FLinearColor Color);
+
+	// Stores a copy of a BGRA image for use by AddSprite and returns its index.
+	// Sprites are converted to the canvas format as they are drawn
+	int32 RegisterSprite(const FColor* Pixels, int32 Width, int32 Height);
+
+	// Records an alpha blended sprite with its top left corner at X, Y
+	void AddSprite(int32 SpriteIndex, int32 X, int32 Y, FLinearColor Tint = FLinearColor::White);
+
+	// Removes all recorded commands, registered sprites are kept
+	void Reset();
+
+	// Removes all recorded commands and sprites
+	void Empty();
+
+	int32 Num() const { return Commands.Num(); }
+
+	const TArray<FDynamicTextureDrawCommand>& GetCommands() const { return Commands; }
+
+	// Rasterizes every command into a pixel buffer of the given size and format
+	void Execute(uint8* Pixels, int32 Width, int32 Height, EDynamicTexturePixelFormat Format = EDynamicTexturePixelFormat::BGRA8) const;
+
+private:
+	// Execute compiled for one pixel format
+	template<typename TPixelTraits>
+	void ExecuteForFormat(uint8* Pixels, int32 Width, int32 Height) const;
+
+	struct FSprite
+	{
+		TArray<FColor> Pixels;
+		int32 Width = 0;
+		int32 Height = 0;
+	};
+
+	TArray<FDynamicTextureDrawCommand> Commands;
+	TArray<FSprite> Sprites;
+};
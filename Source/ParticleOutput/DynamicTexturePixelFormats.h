@@ -0,0 +1,242 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "Engine/TextureDefines.h"
+#include "Math/Float16Color.h"
+#include "DynamicTexturePixelFormats.generated.h"
+
+// CPU side storage formats a UDynamicTexture can be created with
+UENUM(BlueprintType)
+enum class EDynamicTexturePixelFormat : uint8
+{
+	// 4 bytes per pixel, blue green red alpha. Matches FColor
+	BGRA8,
+	// 1 byte per pixel, single channel masks. Written from the red channel
+	R8,
+	// 3 bytes per pixel, red green blue. Expanded to BGRA8 when uploaded, as GPUs have no 24 bit format
+	RGB8,
+	// 8 bytes per pixel, half float red green blue alpha for HDR content
+	RGBA16F
+};
+
+// Packed 24 bit color, laid out in the order LED panels consume it
+struct FDynamicTextureRGB8
+{
+	uint8 R;
+	uint8 G;
+	uint8 B;
+};
+
+/*
+	Compile time description of each pixel format. Every format provides:
+	FPixel					the stored pixel type
+	BytesPerPixel			sizeof(FPixel)
+	UploadBytesPerPixel		size of a pixel in the GPU texture
+	TextureFormat, Compression, bSRGB	settings for the transient texture
+	Pack					converts a linear color once per draw call
+	FromColor				converts an 8 bit BGRA pixel (bulk writes, sprites)
+	Blend					blends Src over Dst with Alpha in 0..256
+	ToUpload				writes a pixel in the GPU layout (only used when the layouts differ)
+*/
+template<EDynamicTexturePixelFormat Format>
+struct TDynamicTexturePixelTraits;
+
+template<>
+struct TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::BGRA8>
+{
+	typedef uint32 FPixel;
+	static constexpr EDynamicTexturePixelFormat Format = EDynamicTexturePixelFormat::BGRA8;
+	static constexpr int32 BytesPerPixel = 4;
+	static constexpr int32 UploadBytesPerPixel = 4;
+	static constexpr EPixelFormat TextureFormat = PF_B8G8R8A8;
+	// The VectorDisplacementMap is a raw RGBA8 format
+	static constexpr TextureCompressionSettings Compression = TC_VectorDisplacementmap;
+	static constexpr bool bSRGB = true;
+
+	static FORCEINLINE FPixel Pack(const FLinearColor& Color)
+	{
+		FColor Packed(
+			uint8(FMath::Clamp(Color.R, 0.0f, 1.0f) * 255),
+			uint8(FMath::Clamp(Color.G, 0.0f, 1.0f) * 255),
+			uint8(FMath::Clamp(Color.B, 0.0f, 1.0f) * 255),
+			uint8(FMath::Clamp(Color.A, 0.0f, 1.0f) * 255));
+		return Packed.DWColor();
+	}
+
+	static FORCEINLINE FPixel FromColor(const FColor& Color)
+	{
+		return Color.DWColor();
+	}
+
+	// Two channels are blended per multiply (red/blue and alpha/green in alternating bytes)
+	static FORCEINLINE FPixel Blend(FPixel Dst, FPixel Src, uint32 Alpha)
+	{
+		const uint32 InvAlpha = 256 - Alpha;
+		const uint32 RB = (((Src & 0x00FF00FF) * Alpha + (Dst & 0x00FF00FF) * InvAlpha) >> 8) & 0x00FF00FF;
+		const uint32 AG = (((Src >> 8) & 0x00FF00FF) * Alpha + ((Dst >> 8) & 0x00FF00FF) * InvAlpha) & 0xFF00FF00;
+		return RB | AG;
+	}
+
+	static FORCEINLINE void ToUpload(const FPixel& Pixel, uint8* Dest)
+	{
+		FMemory::Memcpy(Dest, &Pixel, sizeof(FPixel));
+	}
+};
+
+template<>
+struct TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::R8>
+{
+	typedef uint8 FPixel;
+	static constexpr EDynamicTexturePixelFormat Format = EDynamicTexturePixelFormat::R8;
+	static constexpr int32 BytesPerPixel = 1;
+	static constexpr int32 UploadBytesPerPixel = 1;
+	static constexpr EPixelFormat TextureFormat = PF_G8;
+	static constexpr TextureCompressionSettings Compression = TC_Grayscale;
+	static constexpr bool bSRGB = false;
+
+	static FORCEINLINE FPixel Pack(const FLinearColor& Color)
+	{
+		return uint8(FMath::Clamp(Color.R, 0.0f, 1.0f) * 255);
+	}
+
+	static FORCEINLINE FPixel FromColor(const FColor& Color)
+	{
+		return Color.R;
+	}
+
+	static FORCEINLINE FPixel Blend(FPixel Dst, FPixel Src, uint32 Alpha)
+	{
+		return FPixel((Src * Alpha + Dst * (256 - Alpha)) >> 8);
+	}
+
+	static FORCEINLINE void ToUpload(const FPixel& Pixel, uint8* Dest)
+	{
+		*Dest = Pixel;
+	}
+};
+
+template<>
+struct TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::RGB8>
+{
+	typedef FDynamicTextureRGB8 FPixel;
+	static constexpr EDynamicTexturePixelFormat Format = EDynamicTexturePixelFormat::RGB8;
+	static constexpr int32 BytesPerPixel = 3;
+	static constexpr int32 UploadBytesPerPixel = 4;
+	static constexpr EPixelFormat TextureFormat = PF_B8G8R8A8;
+	static constexpr TextureCompressionSettings Compression = TC_VectorDisplacementmap;
+	static constexpr bool bSRGB = true;
+
+	static FORCEINLINE FPixel Pack(const FLinearColor& Color)
+	{
+		return {
+			uint8(FMath::Clamp(Color.R, 0.0f, 1.0f) * 255),
+			uint8(FMath::Clamp(Color.G, 0.0f, 1.0f) * 255),
+			uint8(FMath::Clamp(Color.B, 0.0f, 1.0f) * 255) };
+	}
+
+	static FORCEINLINE FPixel FromColor(const FColor& Color)
+	{
+		return { Color.R, Color.G, Color.B };
+	}
+
+	static FORCEINLINE FPixel Blend(FPixel Dst, FPixel Src, uint32 Alpha)
+	{
+		const uint32 InvAlpha = 256 - Alpha;
+		return {
+			uint8((Src.R * Alpha + Dst.R * InvAlpha) >> 8),
+			uint8((Src.G * Alpha + Dst.G * InvAlpha) >> 8),
+			uint8((Src.B * Alpha + Dst.B * InvAlpha) >> 8) };
+	}
+
+	static FORCEINLINE void ToUpload(const FPixel& Pixel, uint8* Dest)
+	{
+		Dest[0] = Pixel.B;
+		Dest[1] = Pixel.G;
+		Dest[2] = Pixel.R;
+		Dest[3] = 255;
+	}
+};
+
+template<>
+struct TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::RGBA16F>
+{
+	typedef FFloat16Color FPixel;
+	static constexpr EDynamicTexturePixelFormat Format = EDynamicTexturePixelFormat::RGBA16F;
+	static constexpr int32 BytesPerPixel = 8;
+	static constexpr int32 UploadBytesPerPixel = 8;
+	static constexpr EPixelFormat TextureFormat = PF_FloatRGBA;
+	static constexpr TextureCompressionSettings Compression = TC_HDR;
+	static constexpr bool bSRGB = false;
+
+	// HDR values are stored unclamped
+	static FORCEINLINE FPixel Pack(const FLinearColor& Color)
+	{
+		return FFloat16Color(Color);
+	}
+
+	static FORCEINLINE FPixel FromColor(const FColor& Color)
+	{
+		return FFloat16Color(FLinearColor(Color));
+	}
+
+	static FORCEINLINE FPixel Blend(FPixel Dst, FPixel Src, uint32 Alpha)
+	{
+		const float Weight = Alpha / 256.0f;
+		return FFloat16Color(FMath::Lerp(Dst.GetFloats(), Src.GetFloats(), Weight));
+	}
+
+	static FORCEINLINE void ToUpload(const FPixel& Pixel, uint8* Dest)
+	{
+		FMemory::Memcpy(Dest, &Pixel, sizeof(FPixel));
+	}
+};
+
+typedef TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::BGRA8> FDynamicTexturePixelBGRA8;
+typedef TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::R8> FDynamicTexturePixelR8;
+typedef TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::RGB8> FDynamicTexturePixelRGB8;
+typedef TDynamicTexturePixelTraits<EDynamicTexturePixelFormat::RGBA16F> FDynamicTexturePixelRGBA16F;
+
+// Calls Functor with the traits of the given format, so the body is compiled once per format
+template<typename FunctorType>
+FORCEINLINE auto DispatchDynamicTexturePixelFormat(EDynamicTexturePixelFormat Format, FunctorType&& Functor)
+{
+	switch (Format)
+	{
+	case EDynamicTexturePixelFormat::R8:
+		return Functor(FDynamicTexturePixelR8());
+	case EDynamicTexturePixelFormat::RGB8:
+		return Functor(FDynamicTexturePixelRGB8());
+	case EDynamicTexturePixelFormat::RGBA16F:
+		return Functor(FDynamicTexturePixelRGBA16F());
+	case EDynamicTexturePixelFormat::BGRA8:
+	default:
+		return Functor(FDynamicTexturePixelBGRA8());
+	}
+}
+
+// Bytes per pixel of the CPU side storage for a format
+inline int32 GetDynamicTextureBytesPerPixel(EDynamicTexturePixelFormat Format)
+{
+	return DispatchDynamicTexturePixelFormat(Format, [](auto Traits) { return decltype(Traits)::BytesPerPixel; });
+}
+
+// Writes a region of a storage format buffer Width pixels wide into Dest in the GPU layout,
+// tightly packed at Rect.Width() * UploadBytesPerPixel bytes per row
+template<typename TPixelTraits>
+void ConvertDynamicTextureRegionForUpload(const uint8* Pixels, int32 Width, const FIntRect& Rect, uint8* Dest)
+{
+	typedef typename TPixelTraits::FPixel FPixel;
+	const int32 Pitch = Rect.Width() * TPixelTraits::UploadBytesPerPixel;
+	for (int32 Row = Rect.Min.Y; Row < Rect.Max.Y; Row++)
+	{
+		const FPixel* Source = reinterpret_cast<const FPixel*>(Pixels) + Rect.Min.X + Row * Width;
+		uint8* RowDest = Dest + SIZE_T(Row - Rect.Min.Y) * Pitch;
+		for (int32 Column = 0; Column < Rect.Width(); Column++)
+		{
+			TPixelTraits::ToUpload(Source[Column], RowDest + Column * TPixelTraits::UploadBytesPerPixel);
+		}
+	}
+}
\ No newline at end of file
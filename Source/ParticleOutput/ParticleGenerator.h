@@ -7,9 +7,47 @@
 #include "Math/Rotator.h"
 #include "GameFramework/Character.h"
 #include "TauBuffer.h"
-#include "Containers/CircularBuffer.h"
+#include "TriangleTopology.h"
+#include "TriangleGeometry.h"
+#include "SocketHistory.h"
+#include "SubFramePoseSampler.h"
+#include "SocketRecording.h"
+#include "Tasks/Task.h"
 #include "ParticleGenerator.generated.h"
 
+// One frame of pipeline output, computed off the game thread when bUseAsyncPipeline or
+// bUseAnimationThreadPipeline is set. Published results are never modified, so they can be
+// held and read from any thread
+struct FParticleGeneratorResults
+{
+	// Gathers the triangle corners from every socket's transform and computes the geometry of the listed triangles
+	void Compute(const TArray<FVector>& Locations, const TArray<FRotator>& Rotations, const TArray<int32>& SocketIndices, const TArray<int32>& InTriangles);
+
+	// Takes a tau reading at each sample time from the triangles interpolated between Previous and
+	// this frame, advancing Bank. The readings are kept so another bank can be given them too
+	void Track(FTauStateBank& Bank, const FParticleGeneratorResults& Previous, const TArray<double>& SampleTimes);
+
+	// Advances Bank with the readings Track took
+	void ApplyReadings(FTauStateBank& Bank) const;
+
+	// Frame and time the socket transforms were sampled at
+	uint64 FrameNumber = 0;
+	double SampleTime = 0.0;
+
+	TArray<FVector> TrianglePositions;
+	TArray<FRotator> TriangleRotations;
+
+	// Triangles in Batch, in order, and their vertices and derived geometry
+	TArray<int32> Triangles;
+	FTriangleBatch Batch;
+
+	// Tau readings taken by Track, the Euler line of every triangle at each sample time
+	TArray<double> TrackingSampleTimes;
+	TArray<TArray<FVector>> TrackingEulerLines;
+};
+
+typedef TSharedPtr<const FParticleGeneratorResults, ESPMode::ThreadSafe> FParticleGeneratorResultsPtr;
+
 UCLASS()
 class PARTICLEOUTPUT_API AParticleGenerator : public ACharacter
 {
@@ -19,12 +57,31 @@ public:
 	// Sets default values for this character's properties
 	AParticleGenerator();
 
+	// Time of the last tau reading
 	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
 	double LastReadingTime;
 
+	// Tau readings per second. Readings fall on a fixed grid of times and the triangles are
+	// interpolated between frames to each one, so every reading is the same interval apart
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "1.0"))
+	float TrackingSampleRate = 120.0f;
+
+	// Evaluates the animation at each tracking sample time on a worker task instead of interpolating
+	// between frames. Only meshes playing a single animation sequence can be sampled, others interpolate
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bUseSubFramePoseSampling = false;
+
 	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
 	int SmoothingSamplesCount;
 
+	// How tau dot is estimated. Savitzky-Golay and Kalman react to real gestures several samples
+	// sooner than the difference estimator, which needs a further mean to tame its noise
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	ETauDerivativeEstimator TauDerivativeEstimator = ETauDerivativeEstimator::Difference;
+
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	FTauEstimatorSettings TauEstimatorSettings;
+
 	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
 	TArray<FName> SocketNames;
 
@@ -40,6 +97,21 @@ public:
 	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
 	TArray<FRotator> SocketRotations;
 
+	// Socket locations the triangles are built from, raw or smoothed by one of the history filters
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	ESocketFilter TriangleInputFilter = ESocketFilter::None;
+
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	FSocketFilterSettings SocketFilterSettings;
+
+	// Triangles to track. When unset the built in 67 triangle topology is used
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	UTriangleTopology* TriangleTopology;
+
+	// Three socket indices per triangle, resolved from the topology at BeginPlay
+	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
+	TArray<int32> TriangleSocketIndices;
+
 	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
 	TArray<FVector> TrianglePositions;
 
@@ -64,45 +136,305 @@ public:
 	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
 	TArray<FVector> EulerLines;
 
+	// Blueprint views of each triangle's tau state, only created when bCreateTauBufferViews is set
 	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
 	TArray<UTauBuffer *> TriangleTauBuffers;
 
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bCreateTauBufferViews = false;
+
+	// Readings of each triangle's Euler line kept at full rate
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "2"))
+	int32 MotionPathWindow = 64;
+
+	// Older readings are averaged in groups of CoarseMotionPathStride and kept for CoarseMotionPathWindow
+	// groups, so long range history costs a fixed amount of memory. A stride of 0 discards them
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "0"))
+	int32 CoarseMotionPathStride = 16;
+
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "1"))
+	int32 CoarseMotionPathWindow = 256;
+
+	// Tau state of every triangle
+	const FTauStateBank& GetTauStates() const { return TauStates; }
+
+	// Also runs the scalar triangle path each frame and logs how far the vector kernel is from it
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bValidateTriangleKernel;
+
+	// Also runs the per triangle tau update each reading and logs its deviation and timing against the batched one
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bValidateTauKernel;
+
+	// Measures the angles tau is derived from with a polynomial atan2, within 4e-6 radians
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bFastTauAngle;
+
+	// Draws every triangle with its normal, edge bisectors and Euler line
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bDrawDebugTriangles;
+
+	// Lets UParticleGeneratorSubsystem update this generator together with every other one,
+	// instead of running the whole pipeline in this actor's Tick. The actor still ticks, so
+	// Blueprint Event Tick keeps firing
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bUseBatchedUpdate = false;
+
+	// Keeps the triangle working data as floats relative to the actor, halving the memory the
+	// geometry kernel reads and writes. Published arrays stay in world space. The async and animation
+	// thread pipelines share their results with other threads, so they always compute in world space
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bUseLocalFloatStorage = false;
+
+	// Drops still performers to a low update rate over a reduced set of triangles. Motion above
+	// IdleMotionEnergy switches back to every triangle at full rate on the same frame. The animation
+	// thread pipeline reads the sockets during evaluation, off the game thread, so it always runs at full rate
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bAdaptiveTracking = false;
+
+	// Summed speed of every socket, in cm/s, below which the performer counts as still
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "0.0"))
+	float IdleMotionEnergy = 50.0f;
+
+	// Seconds the performer has to stay still before it goes idle
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "0.0"))
+	float IdleDelay = 0.5f;
+
+	// Seconds between updates while idle
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "0.0"))
+	float IdleUpdateInterval = 0.25f;
+
+	// While idle only every IdleTriangleStride-th triangle is computed and tracked
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "1"))
+	int32 IdleTriangleStride = 4;
+
+	// Summed speed of every socket over the last frame, in cm/s
+	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
+	float MotionEnergy = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
+	bool bIsIdle = false;
+
+	// Computes triangles, their geometry and the tau readings in a background task. Sockets are sampled
+	// at the end of Tick and the results are published at the start of the next one, a frame later
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bUseAsyncPipeline = false;
+
+	// Computes socket transforms, triangles and their geometry on the animation worker thread, right
+	// after the pose is evaluated. The mesh's anim class has to derive from UParticleGeneratorAnimInstance
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	bool bUseAnimationThreadPipeline = false;
+
+	// The most recently published results of the async pipeline, null until the first one completes
+	FParticleGeneratorResultsPtr GetLatestResults() const { return LatestResults; }
+
 	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
 	void UpdateSocketRawData();
 
+	// Records every frame of live socket transforms to this file in the Saved directory
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	FString RecordingFile;
+
+	// Replays a recording from the Saved directory in place of the mesh, reproducing its frames exactly
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator")
+	FString ReplayFile;
+
+	// Recorded seconds replayed per second, frames are never skipped at any speed
+	UPROPERTY(EditAnywhere, Category = "ParticleGenerator", meta = (ClampMin = "0.0"))
+	float ReplaySpeed = 1.0f;
+
+	// Every socket's location as of the last UpdateSocketRawData, smoothed by Filter
+	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
+	TArray<FVector> GetFilteredSocketLocations(ESocketFilter Filter) const;
+
 protected:
+	friend class UParticleGeneratorSubsystem;
+	friend class UParticleGeneratorAnimInstance;
+	friend struct FParticleGeneratorAnimInstanceProxy;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	std::vector < std::vector<float> > LocationSamples;
-	std::vector < std::vector<float> > RotationSamples;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Pipeline stages, run in this order by Tick or by UParticleGeneratorSubsystem
+
+	// Reads the sockets and gathers the triangle corners
+	void UpdatePose();
+
+	// Measures MotionEnergy and decides whether this frame runs, and over which triangles
+	void UpdateMotionEnergy();
+
+	void RebuildActiveTriangles();
+
+	// Triangles computed and tracked this frame, every triangle unless idle
+	TArray<int32> ActiveTriangles;
+
+	// Set on idle frames between updates. The previous results are kept
+	bool bSkipPipeline = false;
+
+	double LastMotionTime = 0.0;
+	double LastIdleUpdateTime = 0.0;
+
+	// Number of triangles this generator puts in a batch this frame
+	int32 GetNumBatchedTriangles() const { return bSkipPipeline ? 0 : ActiveTriangles.Num(); }
+
+	// Takes every tracking sample due between the previous frame and this one
+	void UpdateTrackingStage();
+
+	// UpdateTrackingStage in two halves. The first begins tracking, which creates the views, and
+	// gathers the samples, so it runs on the game thread. The second only advances the tau bank
+	void PrepareTrackingSamples();
+	void TakeTrackingSamples();
+
+	// Corners the pose sampler evaluated at each sample time, null when the samples are interpolated
+	const FVector* SampledTrackingCorners = nullptr;
+
+	// Fills TrackingSampleTimes with the samples due between the previous frame and this one
+	void GatherTrackingSamples();
+
+	// Fills TrackingSampleTimes with the samples due after FromTime, up to ToTime
+	void GatherTrackingSamples(double FromTime, double ToTime);
+
+	// Takes a tau reading at SampleTime from SampledCorners, or from triangle corners interpolated
+	// Alpha of the way from the previous frame to this one when there are none
+	void UpdateTrackingSample(double SampleTime, double Alpha, const FVector* SampledCorners);
+
+	// Begins tracking from, or advances the tau states with, one set of Euler lines
+	void TakeTauReading(double SampleTime, const TArray<FVector>& SampleEulerLines);
+
+	// Times the current and previous triangle corners were sampled at, and where the mesh was then
+	double PoseTime = 0.0;
+	double PreviousPoseTime = 0.0;
+	FTransform PoseComponentToWorld;
+	FTransform PreviousPoseComponentToWorld;
+
+	TArray<double> TrackingSampleTimes;
+	bool bTrackingSamplesGathered = false;
+
+	// Bone and socket offset of every triangle corner, for the pose sampler
+	TArray<int32> CornerBoneIndices;
+	TArray<FTransform> CornerLocalTransforms;
+
+	FSubFramePoseSampler PoseSampler;
+
+	// Set once the mesh has been reported as one the sampler cannot evaluate
+	bool bLoggedPoseSamplerFallback = false;
 
+	// Index of the next sample on the TrackingSampleRate grid, counted from time zero
+	int64 NextTrackingSample = 0;
 
-	TArray<FVector> AB;
-	TArray<FVector> ABmid;
-	TArray<FVector> BC;
-	TArray<FVector> BCmid;
-	TArray<FVector> CA;
-	TArray<FVector> CAmid;
-	TArray<FVector> V;
-	TArray<FVector> D1;
-	TArray<FVector> D2;
-	TArray<FVector> D3;
-	TArray<FVector> ABBC;
+	// Triangles and Euler lines interpolated to a sample time
+	FTriangleBatch TrackingBatch;
+	TArray<FVector> TrackingEulerLines;
 
+	// Writes this generator's triangle corners into a batch, starting at FirstTriangle.
+	// Float batches are relative to StorageOrigin
+	void LoadTriangles(FTriangleBatch& Batch, int32 FirstTriangle) const;
+	void LoadTriangles(FTriangleBatch3f& Batch, int32 FirstTriangle) const;
 
+	// Runs the geometry kernel, checked against the scalar path when bValidate is set
+	static void ComputeTriangleBatch(FTriangleBatch& Batch, bool bValidate);
+	static void ComputeTriangleBatch(FTriangleBatch3f& Batch, bool bValidate);
+
+	// Copies this generator's triangles out of a computed batch, starting at FirstTriangle
+	void ApplyTriangleGeometry(const FTriangleBatch& Batch, int32 FirstTriangle);
+	void ApplyTriangleGeometry(const FTriangleBatch3f& Batch, int32 FirstTriangle);
+
+	// Tick when bUseAsyncPipeline is set: publish last frame's task, then snapshot and launch the next.
+	// Only the first tau reading, which creates the views, is taken on the game thread
+	void TickAsyncPipeline(float DeltaTime);
+
+	// Makes a completed frame the current one, copying it into the Blueprint visible arrays
+	void PublishResults(const FParticleGeneratorResultsPtr& Results);
+
+	// Tick while replaying: runs each recorded frame that is due through every stage
+	void TickReplay(float DeltaTime);
+
+	FSocketRecorder Recorder;
+	FSocketReplay Replay;
+	int32 ReplayFrame = 0;
+	double ReplayClock = 0.0;
+
+	// Time the current and previous socket transforms were sampled at, live or recorded
+	double SocketSampleTime = 0.0;
+	double PreviousSocketSampleTime = 0.0;
+
+	// Tick when bUseAnimationThreadPipeline is set: only tracking is left for the game thread
+	void TickAnimationThreadPipeline();
+
+	// Results the animation thread handed back since the last tick, published by the next one
+	FParticleGeneratorResultsPtr AnimationResults;
+
+	UE::Tasks::FTask PipelineTask;
+	TSharedPtr<FParticleGeneratorResults, ESPMode::ThreadSafe> PendingResults;
+	FParticleGeneratorResultsPtr LatestResults;
+
+	// The bank the async pipeline's task advances while the views read TauStates. The two are swapped
+	// when a frame is published, and UntrackedResults holds the readings the new back bank has yet to take
+	FTauStateBank AsyncTauStates;
+	FParticleGeneratorResultsPtr UntrackedResults;
+
+	// Looks up the bone and local offset of every socket, and sizes the per frame socket storage
+	void CacheSocketBindings();
+
+	// Bone each socket is attached to and the socket's offset from it, cached at BeginPlay
+	TArray<int32> SocketBoneIndices;
+	TArray<FTransform> SocketLocalTransforms;
+
+	// The last SocketHistoryLength frames of raw socket data, and the filters run over them
+	static constexpr int32 SocketHistoryLength = 10;
+	FSocketHistory SocketHistory;
+
+	// Locations the triangle stage reads, SocketLocations or one of the filtered sets
+	const TArray<FVector>& GetTriangleInputLocations() const;
+
+
+	// Vertices and derived geometry of every triangle, refilled each frame
+	FTriangleBatch TriangleBatch;
+
+	// TriangleBatch in actor local float storage, used when bUseLocalFloatStorage is set
+	FTriangleBatch3f LocalTriangleBatch;
+
+	// Actor location this frame's float storage is relative to
+	FVector StorageOrigin = FVector::ZeroVector;
+
+	// The batch this frame's geometry was computed in, this generator's or the subsystem's.
+	// Only one of the two is set
+	const FTriangleBatch* GeometryBatch = nullptr;
+	const FTriangleBatch3f* LocalGeometryBatch = nullptr;
+	int32 GeometryBatchOffset = 0;
+
+	bool bRegisteredWithSubsystem = false;
+
+	// Highest socket index used by the topology, so the gather can bounds check once
+	int32 MaxTriangleSocketIndex = INDEX_NONE;
+
+
+	// Resolves the triangle topology against the mesh's sockets
 	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
-	void UpdateTriangles(TArray<FName>BoneNames, TArray<FVector>Locations, TArray<FRotator>Rotations);
+	void ResolveTriangleTopology();
 
+	// Gathers the resolved triangle corners from this frame's socket data
 	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
-	void UpdateDebugLines();
+	void UpdateTriangles();
 
+	// Computes edges, normals, bisectors, centroids, circumcenters and Euler lines of every triangle
 	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
-	void UpdateEulerLines();
+	void UpdateTriangleGeometry();
 
+	// Draws the triangles and their derived geometry when bDrawDebugTriangles is set
+	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
+	void UpdateDebugLines();
+
+	// Takes a tau reading of this frame's triangles
 	UFUNCTION(BlueprintCallable, Category = "ParticleGenerator")
 	void UpdateTracking();
 
+	void CreateTauBufferViews();
+
+	FTauStateBank TauStates;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ParticleGeneratorAnimInstance.h"
+#include "BonePose.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void FParticleGeneratorAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	const AParticleGenerator* Generator = Cast<AParticleGenerator>(InAnimInstance->GetOwningActor());
+	bEnabled = Generator != nullptr && Generator->bUseAnimationThreadPipeline && Generator->TriangleSocketIndices.Num() > 0;
+	if (!bEnabled) {
+		return;
+	}
+
+	FrameNumber = GFrameCounter;
+	SampleTime = FApp::GetCurrentTime();
+	ComponentToWorld = InAnimInstance->GetSkelMeshComponent()->GetComponentTransform();
+
+	// Bindings and topology only change when the generator resolves them again
+	if (SocketBoneIndices != Generator->SocketBoneIndices || TriangleSocketIndices != Generator->TriangleSocketIndices || Triangles != Generator->ActiveTriangles) {
+		SocketBoneIndices = Generator->SocketBoneIndices;
+		SocketLocalTransforms = Generator->SocketLocalTransforms;
+		TriangleSocketIndices = Generator->TriangleSocketIndices;
+		Triangles = Generator->ActiveTriangles;
+	}
+}
+
+bool FParticleGeneratorAnimInstanceProxy::Evaluate_WithRoot(FPoseContext& Output, FAnimNode_Base* InRootNode)
+{
+	// Linked graphs are evaluated through here too, only the final pose is of interest
+	if (!bEnabled || InRootNode != GetRootNode()) {
+		return FAnimInstanceProxy::Evaluate_WithRoot(Output, InRootNode);
+	}
+
+	if (!FAnimInstanceProxy::Evaluate_WithRoot(Output, InRootNode)) {
+		EvaluateAnimationNode_WithRoot(Output, InRootNode);
+	}
+	ComputeResults(Output.Pose);
+	return true;
+}
+
+void FParticleGeneratorAnimInstanceProxy::ComputeResults(const FCompactPose& Pose)
+{
+	FCSPose<FCompactPose> ComponentPose;
+	ComponentPose.InitPose(Pose);
+	const FBoneContainer& BoneContainer = Pose.GetBoneContainer();
+
+	// Bones dropped by the current LOD leave their sockets at the component origin
+	const int32 NumSockets = SocketBoneIndices.Num();
+	SocketLocations.SetNumUninitialized(NumSockets, false);
+	SocketRotations.SetNumUninitialized(NumSockets, false);
+	for (int32 i = 0; i < NumSockets; i++)
+	{
+		const int32 BoneIndex = SocketBoneIndices[i];
+		const FCompactPoseBoneIndex CompactIndex = BoneIndex != INDEX_NONE ? BoneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(BoneIndex)) : FCompactPoseBoneIndex(INDEX_NONE);
+		const FTransform BoneTransform = CompactIndex.IsValid() ? ComponentPose.GetComponentSpaceTransform(CompactIndex) : FTransform::Identity;
+		const FTransform SocketTransform = SocketLocalTransforms[i] * BoneTransform * ComponentToWorld;
+		SocketLocations[i] = SocketTransform.GetLocation();
+		SocketRotations[i] = SocketTransform.Rotator();
+	}
+
+	TSharedPtr<FParticleGeneratorResults, ESPMode::ThreadSafe> Results = MakeShared<FParticleGeneratorResults, ESPMode::ThreadSafe>();
+	Results->FrameNumber = FrameNumber;
+	Results->SampleTime = SampleTime;
+	Results->Compute(SocketLocations, SocketRotations, TriangleSocketIndices, Triangles);
+	PendingResults = Results;
+}
+
+void UParticleGeneratorAnimInstance::NativePostEvaluateAnimation()
+{
+	Super::NativePostEvaluateAnimation();
+
+	if (!Proxy.PendingResults.IsValid()) {
+		return;
+	}
+	if (AParticleGenerator* Generator = Cast<AParticleGenerator>(GetOwningActor())) {
+		Generator->AnimationResults = Proxy.PendingResults;
+	}
+	Proxy.PendingResults.Reset();
+}
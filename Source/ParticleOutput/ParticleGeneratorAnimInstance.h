@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "ParticleGenerator.h"
+#include "ParticleGeneratorAnimInstance.generated.h"
+
+/*
+	Runs an AParticleGenerator's triangle stage inside animation evaluation.
+	As soon as the worker thread has produced the pose, the sockets are read
+	from it, the triangles gathered and their geometry computed, while the
+	pose is still in cache. The finished FParticleGeneratorResults are handed
+	to the generator once evaluation completes and published on its next tick.
+*/
+USTRUCT()
+struct PARTICLEOUTPUT_API FParticleGeneratorAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FParticleGeneratorAnimInstanceProxy() {}
+	FParticleGeneratorAnimInstanceProxy(UAnimInstance* InAnimInstance) : FAnimInstanceProxy(InAnimInstance) {}
+
+	// Results of the last evaluation, taken by the anim instance on the game thread
+	TSharedPtr<FParticleGeneratorResults, ESPMode::ThreadSafe> PendingResults;
+
+protected:
+	// Game thread: copies what evaluation needs from the generator
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	// Worker thread: evaluates the graph, then computes the triangles from the pose it produced
+	virtual bool Evaluate_WithRoot(FPoseContext& Output, FAnimNode_Base* InRootNode) override;
+
+private:
+	void ComputeResults(const FCompactPose& Pose);
+
+	bool bEnabled = false;
+	uint64 FrameNumber = 0;
+	double SampleTime = 0.0;
+	FTransform ComponentToWorld;
+
+	// The generator's socket bindings and topology, copied when they change
+	TArray<int32> SocketBoneIndices;
+	TArray<FTransform> SocketLocalTransforms;
+	TArray<int32> TriangleSocketIndices;
+	TArray<int32> Triangles;
+
+	TArray<FVector> SocketLocations;
+	TArray<FRotator> SocketRotations;
+};
+
+// Anim class to reparent a generator's animation blueprint to when bUseAnimationThreadPipeline is set
+UCLASS(Transient, Blueprintable)
+class PARTICLEOUTPUT_API UParticleGeneratorAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return &Proxy; }
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
+
+	// Hands the evaluated results to the generator, back on the game thread
+	virtual void NativePostEvaluateAnimation() override;
+
+private:
+	UPROPERTY(Transient)
+	FParticleGeneratorAnimInstanceProxy Proxy;
+};
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ParticleGeneratorSubsystem.h"
+#include "ParticleGenerator.h"
+#include "Async/ParallelFor.h"
+
+void UParticleGeneratorSubsystem::RegisterGenerator(AParticleGenerator* Generator)
+{
+	Generators.AddUnique(Generator);
+}
+
+void UParticleGeneratorSubsystem::UnregisterGenerator(AParticleGenerator* Generator)
+{
+	Generators.Remove(Generator);
+}
+
+bool UParticleGeneratorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UParticleGeneratorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UParticleGeneratorSubsystem, STATGROUP_Tickables);
+}
+
+template<typename T>
+void UParticleGeneratorSubsystem::UpdateGeometry(TTriangleBatch<T>& SharedBatch)
+{
+	// Lay every generator's triangles out back to back in the shared batch
+	const int32 NumGenerators = Generators.Num();
+	FirstTriangles.SetNumUninitialized(NumGenerators, false);
+	int32 NumTriangles = 0;
+	bool bValidate = false;
+	for (int32 i = 0; i < NumGenerators; i++)
+	{
+		FirstTriangles[i] = NumTriangles;
+		NumTriangles += Generators[i]->GetNumBatchedTriangles();
+		bValidate |= Generators[i]->bValidateTriangleKernel;
+	}
+	SharedBatch.SetNum(NumTriangles);
+
+	// Loading and applying only touch each generator's own arrays, so they run in parallel
+	ParallelFor(NumGenerators, [this, &SharedBatch](int32 i)
+	{
+		Generators[i]->LoadTriangles(SharedBatch, FirstTriangles[i]);
+	});
+
+	AParticleGenerator::ComputeTriangleBatch(SharedBatch, bValidate);
+
+	ParallelFor(NumGenerators, [this, &SharedBatch](int32 i)
+	{
+		Generators[i]->ApplyTriangleGeometry(SharedBatch, FirstTriangles[i]);
+	});
+}
+
+void UParticleGeneratorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	Generators.RemoveAll([](const AParticleGenerator* Generator) { return !IsValid(Generator); });
+	const int32 NumGenerators = Generators.Num();
+	if (NumGenerators == 0) {
+		return;
+	}
+
+	// Pose. Reading meshes, sockets and animation state is only safe on the game thread
+	for (AParticleGenerator* Generator : Generators)
+	{
+		Generator->UpdatePose();
+	}
+
+	// Float storage is relative to each performer, so it can only be shared when every one uses it
+	bool bAllLocalFloat = true;
+	for (const AParticleGenerator* Generator : Generators)
+	{
+		bAllLocalFloat &= Generator->bUseLocalFloatStorage;
+	}
+	if (bAllLocalFloat) {
+		UpdateGeometry(LocalBatch);
+	}
+	else {
+		UpdateGeometry(Batch);
+	}
+
+	// Drawing into the world and creating the tau buffer views stay on the game thread
+	for (AParticleGenerator* Generator : Generators)
+	{
+		Generator->UpdateDebugLines();
+		Generator->PrepareTrackingSamples();
+	}
+
+	// Each tau bank is plain data owned by its generator, and the views are only read once this returns
+	ParallelFor(NumGenerators, [this](int32 i)
+	{
+		Generators[i]->TakeTrackingSamples();
+	});
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TriangleGeometry.h"
+#include "ParticleGeneratorSubsystem.generated.h"
+
+class AParticleGenerator;
+
+/*
+	Updates every registered AParticleGenerator together, once per frame, so the
+	geometry of many performers is computed in one pass instead of one per actor.
+	Each stage of the pipeline runs over all generators before the next starts:
+
+	1. Pose: socket transforms and triangle corners, on the game thread since
+	   it reads the meshes and their animation
+	2. Geometry: every generator's triangles gathered into one batch in parallel,
+	   computed in a single kernel pass, then scattered back in parallel
+	3. Debug drawing and the start of tracking on the game thread, then every
+	   generator's tau readings in parallel
+*/
+UCLASS()
+class PARTICLEOUTPUT_API UParticleGeneratorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterGenerator(AParticleGenerator* Generator);
+	void UnregisterGenerator(AParticleGenerator* Generator);
+
+	UFUNCTION(BlueprintPure, Category = "ParticleGenerator")
+	int32 GetNumGenerators() const { return Generators.Num(); }
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY(Transient)
+	TArray<AParticleGenerator*> Generators;
+
+	// Gathers, computes and scatters the triangles of every generator in one shared batch
+	template<typename T>
+	void UpdateGeometry(TTriangleBatch<T>& SharedBatch);
+
+	// Triangles of every generator, generator i starting at FirstTriangles[i].
+	// LocalBatch is used when every generator keeps actor local float storage
+	FTriangleBatch Batch;
+	FTriangleBatch3f LocalBatch;
+	TArray<int32> FirstTriangles;
+};
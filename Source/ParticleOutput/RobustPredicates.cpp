@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RobustPredicates.h"
+#include <atomic>
+
+// Expansion arithmetic relies on every operation being rounded exactly once,
+// so contractions into fused multiply-adds and reassociation must stay off here
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma float_control(precise, on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+// Half an ulp of 1.0 and the constant that splits a double into two 26 bit halves
+static constexpr double PredicateEpsilon = 1.1102230246251565e-16;
+static constexpr double PredicateSplitter = 134217729.0;
+
+const double FRobustPredicates::Orient2DErrorBound = (3.0 + 16.0 * PredicateEpsilon) * PredicateEpsilon;
+
+static std::atomic<uint64> Orient2DCallsCount(0);
+static std::atomic<uint64> Orient2DExactCount(0);
+
+// x + y == a + b exactly, with x the rounded sum
+static FORCEINLINE void TwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	const double bvirt = x - a;
+	const double avirt = x - bvirt;
+	const double bround = b - bvirt;
+	const double around = a - avirt;
+	y = around + bround;
+}
+
+// Same as TwoSum when |a| >= |b|
+static FORCEINLINE void FastTwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	const double bvirt = x - a;
+	y = b - bvirt;
+}
+
+static FORCEINLINE void TwoDiff(double a, double b, double& x, double& y)
+{
+	x = a - b;
+	const double bvirt = a - x;
+	const double avirt = x + bvirt;
+	const double bround = bvirt - b;
+	const double around = a - avirt;
+	y = around + bround;
+}
+
+static FORCEINLINE void Split(double a, double& ahi, double& alo)
+{
+	const double c = PredicateSplitter * a;
+	const double abig = c - a;
+	ahi = c - abig;
+	alo = a - ahi;
+}
+
+static FORCEINLINE void TwoProductPresplit(double a, double b, double bhi, double blo, double& x, double& y)
+{
+	x = a * b;
+	double ahi, alo;
+	Split(a, ahi, alo);
+	const double err1 = x - (ahi * bhi);
+	const double err2 = err1 - (alo * bhi);
+	const double err3 = err2 - (ahi * blo);
+	y = (alo * blo) - err3;
+}
+
+// x + y == a * b exactly
+static FORCEINLINE void TwoProduct(double a, double b, double& x, double& y)
+{
+	double bhi, blo;
+	Split(b, bhi, blo);
+	TwoProductPresplit(a, b, bhi, blo, x, y);
+}
+
+// The four term expansion of (a1 + a0) - (b1 + b0)
+static FORCEINLINE void TwoTwoDiff(double a1, double a0, double b1, double b0, double* x)
+{
+	double i, j, k;
+	TwoDiff(a0, b0, i, x[0]);
+	TwoSum(a1, i, j, k);
+	TwoDiff(k, b1, i, x[1]);
+	TwoSum(j, i, x[3], x[2]);
+}
+
+// h = e + f, with zero components removed. Returns the length of h
+static int32 FastExpansionSumZeroElim(int32 elen, const double* e, int32 flen, const double* f, double* h)
+{
+	double Q, Qnew, hh;
+	int32 eindex = 0, findex = 0, hindex = 0;
+	double enow = e[0];
+	double fnow = f[0];
+
+	if ((fnow > enow) == (fnow > -enow)) {
+		Q = enow;
+		enow = ++eindex < elen ? e[eindex] : 0.0;
+	}
+	else {
+		Q = fnow;
+		fnow = ++findex < flen ? f[findex] : 0.0;
+	}
+
+	if (eindex < elen && findex < flen) {
+		if ((fnow > enow) == (fnow > -enow)) {
+			FastTwoSum(enow, Q, Qnew, hh);
+			enow = ++eindex < elen ? e[eindex] : 0.0;
+		}
+		else {
+			FastTwoSum(fnow, Q, Qnew, hh);
+			fnow = ++findex < flen ? f[findex] : 0.0;
+		}
+		Q = Qnew;
+		if (hh != 0.0) {
+			h[hindex++] = hh;
+		}
+		while (eindex < elen && findex < flen) {
+			if ((fnow > enow) == (fnow > -enow)) {
+				TwoSum(Q, enow, Qnew, hh);
+				enow = ++eindex < elen ? e[eindex] : 0.0;
+			}
+			else {
+				TwoSum(Q, fnow, Qnew, hh);
+				fnow = ++findex < flen ? f[findex] : 0.0;
+			}
+			Q = Qnew;
+			if (hh != 0.0) {
+				h[hindex++] = hh;
+			}
+		}
+	}
+	while (eindex < elen) {
+		TwoSum(Q, enow, Qnew, hh);
+		enow = ++eindex < elen ? e[eindex] : 0.0;
+		Q = Qnew;
+		if (hh != 0.0) {
+			h[hindex++] = hh;
+		}
+	}
+	while (findex < flen) {
+		TwoSum(Q, fnow, Qnew, hh);
+		fnow = ++findex < flen ? f[findex] : 0.0;
+		Q = Qnew;
+		if (hh != 0.0) {
+			h[hindex++] = hh;
+		}
+	}
+	if (Q != 0.0 || hindex == 0) {
+		h[hindex++] = Q;
+	}
+	return hindex;
+}
+
+// The four term expansion of a[0] * b[1] - b[0] * a[1]
+static FORCEINLINE void CrossTerms(const double* pa, const double* pb, double* x)
+{
+	double ab1, ab0, ba1, ba0;
+	TwoProduct(pa[0], pb[1], ab1, ab0);
+	TwoProduct(pb[0], pa[1], ba1, ba0);
+	TwoTwoDiff(ab1, ab0, ba1, ba0, x);
+}
+
+static double Orient2DExact(const double* pa, const double* pb, const double* pc)
+{
+	// The determinant expands to ab + bc + ca, where xy = x[0] * y[1] - y[0] * x[1]
+	double ab[4], bc[4], ca[4], v[8], w[12];
+	CrossTerms(pa, pb, ab);
+	CrossTerms(pb, pc, bc);
+	CrossTerms(pc, pa, ca);
+	const int32 vlen = FastExpansionSumZeroElim(4, ab, 4, bc, v);
+	const int32 wlen = FastExpansionSumZeroElim(vlen, v, 4, ca, w);
+	return w[wlen - 1];
+}
+
+double FRobustPredicates::Orient2D(const double* pa, const double* pb, const double* pc)
+{
+	Orient2DCallsCount.fetch_add(1, std::memory_order_relaxed);
+
+	const double detleft = (pa[0] - pc[0]) * (pb[1] - pc[1]);
+	const double detright = (pa[1] - pc[1]) * (pb[0] - pc[0]);
+	const double det = detleft - detright;
+
+	// When both products have the same sign the subtraction can cancel, otherwise the sign is already certain
+	double detsum;
+	if (detleft > 0.0) {
+		if (detright <= 0.0) {
+			return det;
+		}
+		detsum = detleft + detright;
+	}
+	else if (detleft < 0.0) {
+		if (detright >= 0.0) {
+			return det;
+		}
+		detsum = -detleft - detright;
+	}
+	else {
+		return det;
+	}
+
+	const double errbound = Orient2DErrorBound * detsum;
+	if (det >= errbound || -det >= errbound) {
+		return det;
+	}
+
+	Orient2DExactCount.fetch_add(1, std::memory_order_relaxed);
+	return Orient2DExact(pa, pb, pc);
+}
+
+FRobustPredicates::FStats FRobustPredicates::GetStats()
+{
+	FStats Stats;
+	Stats.Orient2DCalls = Orient2DCallsCount.load(std::memory_order_relaxed);
+	Stats.Orient2DExact = Orient2DExactCount.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void FRobustPredicates::ResetStats()
+{
+	Orient2DCallsCount.store(0, std::memory_order_relaxed);
+	Orient2DExactCount.store(0, std::memory_order_relaxed);
+}
+
+void FRobustPredicates::RecordFilteredOrient2D(uint64 Count)
+{
+	Orient2DCallsCount.fetch_add(Count, std::memory_order_relaxed);
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+	Adaptive 2D orientation predicate after Shewchuk's robust predicates
+	(http://www.cs.cmu.edu/~quake/robust.html). It first evaluates the
+	determinant in plain floating point and checks it against a forward
+	error bound. Only when the bound is exceeded is the determinant recomputed
+	with exact expansion arithmetic, so the common case costs a few extra
+	multiplies. The results assume strict IEEE double arithmetic.
+*/
+struct PARTICLEOUTPUT_API FRobustPredicates
+{
+	// Relative error bound of the floating point filter
+	static const double Orient2DErrorBound;
+
+	// Twice the signed area of triangle a b c, positive when counterclockwise
+	static double Orient2D(const double* pa, const double* pb, const double* pc);
+
+	// Number of evaluations, and how many of them needed exact arithmetic
+	struct FStats
+	{
+		uint64 Orient2DCalls = 0;
+		uint64 Orient2DExact = 0;
+	};
+
+	static FStats GetStats();
+	static void ResetStats();
+
+	// Counts evaluations a caller filtered itself, e.g. the lanes of a vector kernel
+	static void RecordFilteredOrient2D(uint64 Count);
+};
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SocketHistory.h"
+
+// Smoothing factor of a first order low pass filter with the given cutoff, sampled every DeltaTime seconds
+static FORCEINLINE double LowPassAlpha(double Cutoff, double DeltaTime)
+{
+	const double TimeConstant = 1.0 / (2.0 * PI * FMath::Max(Cutoff, UE_SMALL_NUMBER));
+	return 1.0 / (1.0 + TimeConstant / DeltaTime);
+}
+
+void FSocketHistory::Reset(int32 InNumSockets, int32 InCapacity)
+{
+	NumSockets = InNumSockets;
+	Capacity = FMath::Max(InCapacity, 1);
+	NumFrames = 0;
+	Head = 0;
+	LastSampleTime = 0.0;
+
+	LocationSamples.SetNumZeroed(Capacity * NumSockets * 3);
+	RotationSamples.SetNumZeroed(Capacity * NumSockets * 3);
+
+	RawLocations.SetNumZeroed(NumSockets);
+	WindowSums.SetNumZeroed(NumSockets);
+	MovingAverages.SetNumZeroed(NumSockets);
+	ExponentialLocations.SetNumZeroed(NumSockets);
+	OneEuroLocations.SetNumZeroed(NumSockets);
+	OneEuroVelocities.SetNumZeroed(NumSockets);
+}
+
+void FSocketHistory::AddFrame(const TArray<FVector>& Locations, const TArray<FRotator>& Rotations, double SampleTime, const FSocketFilterSettings& Settings)
+{
+	check(Locations.Num() == NumSockets && Rotations.Num() == NumSockets);
+
+	// The first frame seeds every filter with the raw value
+	const bool bFirstFrame = NumFrames == 0;
+	const bool bWindowFull = NumFrames == Capacity;
+	const double DeltaTime = bFirstFrame ? 0.0 : SampleTime - LastSampleTime;
+	const bool bAdvanceFilters = !bFirstFrame && DeltaTime > 0.0;
+
+	const double ExponentialAlpha = FMath::Clamp<double>(Settings.ExponentialAlpha, 0.0, 1.0);
+	const double DerivativeAlpha = bAdvanceFilters ? LowPassAlpha(Settings.OneEuroDerivativeCutoff, DeltaTime) : 1.0;
+
+	NumFrames = FMath::Min(NumFrames + 1, Capacity);
+	const double WindowScale = 1.0 / NumFrames;
+
+	float* SlotLocations = LocationSamples.GetData() + Head * NumSockets * 3;
+	float* SlotRotations = RotationSamples.GetData() + Head * NumSockets * 3;
+	for (int32 i = 0; i < NumSockets; i++)
+	{
+		const FVector& Location = Locations[i];
+		const FRotator& Rotation = Rotations[i];
+		RawLocations[i] = Location;
+
+		// The window sum adds and removes the stored float samples, so it does not drift.
+		// The slot being overwritten holds the sample that leaves the window
+		const FVector Stored(float(Location.X), float(Location.Y), float(Location.Z));
+		FVector Sum = WindowSums[i] + Stored;
+		if (bWindowFull) {
+			Sum -= FVector(SlotLocations[i * 3], SlotLocations[i * 3 + 1], SlotLocations[i * 3 + 2]);
+		}
+		WindowSums[i] = Sum;
+		MovingAverages[i] = Sum * WindowScale;
+
+		SlotLocations[i * 3] = Location.X;
+		SlotLocations[i * 3 + 1] = Location.Y;
+		SlotLocations[i * 3 + 2] = Location.Z;
+
+		SlotRotations[i * 3] = Rotation.Roll;
+		SlotRotations[i * 3 + 1] = Rotation.Pitch;
+		SlotRotations[i * 3 + 2] = Rotation.Yaw;
+
+		if (bFirstFrame) {
+			ExponentialLocations[i] = Location;
+			OneEuroLocations[i] = Location;
+			OneEuroVelocities[i] = FVector::ZeroVector;
+			continue;
+		}
+
+		ExponentialLocations[i] = FMath::Lerp(ExponentialLocations[i], Location, ExponentialAlpha);
+
+		if (bAdvanceFilters) {
+			// The cutoff follows the smoothed speed, so fast motion is filtered less and lags less
+			const FVector Velocity = (Location - OneEuroLocations[i]) / DeltaTime;
+			OneEuroVelocities[i] = FMath::Lerp(OneEuroVelocities[i], Velocity, DerivativeAlpha);
+			const double Cutoff = Settings.OneEuroMinCutoff + Settings.OneEuroBeta * OneEuroVelocities[i].Size();
+			OneEuroLocations[i] = FMath::Lerp(OneEuroLocations[i], Location, LowPassAlpha(Cutoff, DeltaTime));
+		}
+	}
+
+	Head = (Head + 1) % Capacity;
+	LastSampleTime = SampleTime;
+}
+
+FVector FSocketHistory::GetLocation(int32 Socket, int32 Age) const
+{
+	check(Age >= 0 && Age < NumFrames && Socket >= 0 && Socket < NumSockets);
+	const float* Sample = LocationSamples.GetData() + (GetSlot(Age) * NumSockets + Socket) * 3;
+	return FVector(Sample[0], Sample[1], Sample[2]);
+}
+
+FRotator FSocketHistory::GetRotation(int32 Socket, int32 Age) const
+{
+	check(Age >= 0 && Age < NumFrames && Socket >= 0 && Socket < NumSockets);
+	const float* Sample = RotationSamples.GetData() + (GetSlot(Age) * NumSockets + Socket) * 3;
+	return FRotator(Sample[1], Sample[2], Sample[0]);
+}
+
+const TArray<FVector>& FSocketHistory::GetFilteredLocations(ESocketFilter Filter) const
+{
+	switch (Filter)
+	{
+	case ESocketFilter::MovingAverage:
+		return MovingAverages;
+	case ESocketFilter::Exponential:
+		return ExponentialLocations;
+	case ESocketFilter::OneEuro:
+		return OneEuroLocations;
+	case ESocketFilter::None:
+	default:
+		return RawLocations;
+	}
+}
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SocketHistory.generated.h"
+
+// Smoothing applied to socket locations before they are used
+UENUM(BlueprintType)
+enum class ESocketFilter : uint8
+{
+	// Raw locations read from the mesh this frame
+	None,
+	// Mean of the samples in the history window
+	MovingAverage,
+	// Exponentially weighted mean, weighted by ExponentialAlpha
+	Exponential,
+	// One Euro filter, smooths slow motion heavily and fast motion lightly
+	OneEuro
+};
+
+USTRUCT(BlueprintType)
+struct FSocketFilterSettings
+{
+	GENERATED_BODY()
+
+	// Weight of the newest sample in the exponential filter, 1 disables smoothing
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SocketFilter", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float ExponentialAlpha = 0.5f;
+
+	// One Euro cutoff frequency in Hz when the socket is still. Lower removes more jitter
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SocketFilter", meta = (ClampMin = "0.0"))
+	float OneEuroMinCutoff = 1.0f;
+
+	// How fast the One Euro cutoff rises with speed. Higher reduces lag on fast motion
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SocketFilter", meta = (ClampMin = "0.0"))
+	float OneEuroBeta = 0.007f;
+
+	// Cutoff frequency in Hz of the speed estimate the One Euro filter adapts to
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SocketFilter", meta = (ClampMin = "0.0"))
+	float OneEuroDerivativeCutoff = 1.0f;
+};
+
+/*
+	The last Capacity frames of every socket's location and rotation, stored in a
+	ring so adding a frame never moves the older ones. Every filter is updated
+	incrementally as a frame is added, so each costs O(1) per socket regardless
+	of the window size.
+*/
+class PARTICLEOUTPUT_API FSocketHistory
+{
+public:
+	// Clears the history and sizes it for NumSockets sockets
+	void Reset(int32 InNumSockets, int32 InCapacity);
+
+	// Adds one frame of socket transforms sampled at SampleTime seconds
+	void AddFrame(const TArray<FVector>& Locations, const TArray<FRotator>& Rotations, double SampleTime, const FSocketFilterSettings& Settings);
+
+	// Number of frames stored, at most GetCapacity()
+	int32 Num() const { return NumFrames; }
+	int32 GetCapacity() const { return Capacity; }
+	int32 GetNumSockets() const { return NumSockets; }
+
+	// Raw samples of a socket, Age 0 being the newest frame
+	FVector GetLocation(int32 Socket, int32 Age) const;
+	FRotator GetRotation(int32 Socket, int32 Age) const;
+
+	// Filtered location of every socket as of the newest frame
+	const TArray<FVector>& GetFilteredLocations(ESocketFilter Filter) const;
+
+private:
+	int32 GetSlot(int32 Age) const { return (Head - 1 - Age + Capacity) % Capacity; }
+
+	int32 NumSockets = 0;
+	int32 Capacity = 0;
+	int32 NumFrames = 0;
+
+	// Slot the next frame is written to
+	int32 Head = 0;
+
+	// Three floats per socket per frame, frame slots in ring order
+	TArray<float> LocationSamples;
+	TArray<float> RotationSamples;
+
+	TArray<FVector> RawLocations;
+
+	// Running sum of the samples in the window, for the moving average
+	TArray<FVector> WindowSums;
+	TArray<FVector> MovingAverages;
+
+	TArray<FVector> ExponentialLocations;
+
+	TArray<FVector> OneEuroLocations;
+	TArray<FVector> OneEuroVelocities;
+
+	double LastSampleTime = 0.0;
+};
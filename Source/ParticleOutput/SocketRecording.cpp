@@ -0,0 +1,237 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SocketRecording.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+// "PGSR" and the version of the layout below
+#define SOCKET_RECORDING_MAGIC 0x52534750
+#define SOCKET_RECORDING_VERSION 1
+
+// Each chunk starts with its frame count, decompressed size and compressed size
+#define SOCKET_RECORDING_CHUNK_HEADER_SIZE (3 * sizeof(int32))
+
+// A frame is its sample time followed by six doubles per socket
+static int64 GetFrameSize(int32 NumSockets)
+{
+	return sizeof(double) + int64(NumSockets) * 6 * sizeof(double);
+}
+
+FSocketRecorder::~FSocketRecorder()
+{
+	End();
+}
+
+bool FSocketRecorder::Begin(const FString& Filename, const TArray<FName>& SocketNames, int32 InFramesPerChunk)
+{
+	End();
+
+	IFileHandle* Handle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename);
+	if (Handle == nullptr) {
+		UE_LOG(LogTemp, Warning, TEXT("Could not create socket recording %s"), *Filename);
+		return false;
+	}
+	File = TSharedPtr<IFileHandle, ESPMode::ThreadSafe>(Handle);
+	NumSockets = SocketNames.Num();
+	FramesPerChunk = FMath::Max(InFramesPerChunk, 1);
+
+	TArray<uint8> Header;
+	FMemoryWriter Writer(Header);
+	uint32 Magic = SOCKET_RECORDING_MAGIC;
+	uint32 Version = SOCKET_RECORDING_VERSION;
+	TArray<FName> Names = SocketNames;
+	Writer << Magic << Version << FramesPerChunk << Names;
+	File->Write(Header.GetData(), Header.Num());
+
+	Chunk.Reset(FramesPerChunk * GetFrameSize(NumSockets));
+	NumChunkFrames = 0;
+	return true;
+}
+
+void FSocketRecorder::AddFrame(double SampleTime, const TArray<FVector>& Locations, const TArray<FRotator>& Rotations)
+{
+	if (!File.IsValid() || Locations.Num() != NumSockets || Rotations.Num() != NumSockets) {
+		return;
+	}
+
+	const int64 Offset = Chunk.Num();
+	Chunk.AddUninitialized(GetFrameSize(NumSockets));
+	double* Values = reinterpret_cast<double*>(Chunk.GetData() + Offset);
+	*Values++ = SampleTime;
+	for (int32 i = 0; i < NumSockets; i++)
+	{
+		*Values++ = Locations[i].X;
+		*Values++ = Locations[i].Y;
+		*Values++ = Locations[i].Z;
+		*Values++ = Rotations[i].Pitch;
+		*Values++ = Rotations[i].Yaw;
+		*Values++ = Rotations[i].Roll;
+	}
+
+	if (++NumChunkFrames == FramesPerChunk) {
+		FlushChunk();
+	}
+}
+
+void FSocketRecorder::FlushChunk()
+{
+	if (NumChunkFrames == 0) {
+		return;
+	}
+
+	WriteTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[File = File, Frames = MoveTemp(Chunk), NumFrames = NumChunkFrames]()
+		{
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Frames.Num());
+			TArray<uint8> Compressed;
+			Compressed.SetNumUninitialized(SOCKET_RECORDING_CHUNK_HEADER_SIZE + CompressedSize);
+			if (!FCompression::CompressMemory(NAME_Zlib, Compressed.GetData() + SOCKET_RECORDING_CHUNK_HEADER_SIZE, CompressedSize, Frames.GetData(), Frames.Num())) {
+				UE_LOG(LogTemp, Warning, TEXT("Could not compress a socket recording chunk of %i frames"), NumFrames);
+				return;
+			}
+
+			const int32 ChunkHeader[3] = { NumFrames, Frames.Num(), CompressedSize };
+			FMemory::Memcpy(Compressed.GetData(), ChunkHeader, SOCKET_RECORDING_CHUNK_HEADER_SIZE);
+			File->Write(Compressed.GetData(), SOCKET_RECORDING_CHUNK_HEADER_SIZE + CompressedSize);
+		},
+		UE::Tasks::Prerequisites(WriteTask));
+
+	Chunk.Reset(FramesPerChunk * GetFrameSize(NumSockets));
+	NumChunkFrames = 0;
+}
+
+void FSocketRecorder::End()
+{
+	if (!File.IsValid()) {
+		return;
+	}
+	FlushChunk();
+	WriteTask.Wait();
+	WriteTask = UE::Tasks::FTask();
+	File->Flush();
+	File.Reset();
+}
+
+FSocketReplay::~FSocketReplay()
+{
+	Close();
+}
+
+bool FSocketReplay::Open(const FString& Filename)
+{
+	Close();
+
+	MappedFile = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename);
+	Region = MappedFile != nullptr ? MappedFile->MapRegion() : nullptr;
+	if (Region == nullptr) {
+		UE_LOG(LogTemp, Warning, TEXT("Could not map socket recording %s"), *Filename);
+		Close();
+		return false;
+	}
+	const uint8* Data = Region->GetMappedPtr();
+	const int64 Size = Region->GetMappedSize();
+
+	FMemoryReaderView Reader(TArrayView<const uint8>(Data, Size));
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version << FramesPerChunk;
+	if (Magic != SOCKET_RECORDING_MAGIC || Version != SOCKET_RECORDING_VERSION || FramesPerChunk <= 0) {
+		UE_LOG(LogTemp, Warning, TEXT("%s is not a socket recording"), *Filename);
+		Close();
+		return false;
+	}
+	Reader << SocketNames;
+	if (Reader.IsError()) {
+		Close();
+		return false;
+	}
+
+	// Walk the chunk headers. A chunk cut short by the end of the file is ignored
+	int64 Offset = Reader.Tell();
+	const int64 FrameSize = GetFrameSize(SocketNames.Num());
+	while (Offset + int64(SOCKET_RECORDING_CHUNK_HEADER_SIZE) <= Size)
+	{
+		int32 ChunkHeader[3];
+		FMemory::Memcpy(ChunkHeader, Data + Offset, SOCKET_RECORDING_CHUNK_HEADER_SIZE);
+		const int64 DataOffset = Offset + SOCKET_RECORDING_CHUNK_HEADER_SIZE;
+		if (ChunkHeader[0] <= 0 || ChunkHeader[0] > FramesPerChunk || ChunkHeader[1] != ChunkHeader[0] * FrameSize || DataOffset + ChunkHeader[2] > Size) {
+			break;
+		}
+		ChunkOffsets.Add(DataOffset);
+		ChunkSizes.Add(ChunkHeader[1]);
+		ChunkCompressedSizes.Add(ChunkHeader[2]);
+		NumFrames += ChunkHeader[0];
+		Offset = DataOffset + ChunkHeader[2];
+
+		// Only the last chunk may be partial, so frame indices map straight to chunks
+		if (ChunkHeader[0] < FramesPerChunk) {
+			break;
+		}
+	}
+
+	StartTime = NumFrames > 0 ? GetFrameTime(0) : 0.0;
+	UE_LOG(LogTemp, Display, TEXT("Replaying %i frames of %i sockets from %s"), NumFrames, SocketNames.Num(), *Filename);
+	return true;
+}
+
+void FSocketReplay::Close()
+{
+	delete Region;
+	Region = nullptr;
+	delete MappedFile;
+	MappedFile = nullptr;
+
+	SocketNames.Reset();
+	FramesPerChunk = 0;
+	NumFrames = 0;
+	StartTime = 0.0;
+	ChunkOffsets.Reset();
+	ChunkCompressedSizes.Reset();
+	ChunkSizes.Reset();
+	Chunk.Reset();
+	LoadedChunk = INDEX_NONE;
+}
+
+int64 FSocketReplay::LoadFrame(int32 Frame)
+{
+	check(Frame >= 0 && Frame < NumFrames);
+	const int32 ChunkIndex = Frame / FramesPerChunk;
+	if (ChunkIndex != LoadedChunk) {
+		Chunk.SetNumUninitialized(ChunkSizes[ChunkIndex], false);
+		const bool bInflated = FCompression::UncompressMemory(NAME_Zlib, Chunk.GetData(), Chunk.Num(), Region->GetMappedPtr() + ChunkOffsets[ChunkIndex], ChunkCompressedSizes[ChunkIndex]);
+		if (!bInflated) {
+			UE_LOG(LogTemp, Warning, TEXT("Socket recording chunk %i is corrupt"), ChunkIndex);
+			FMemory::Memzero(Chunk.GetData(), Chunk.Num());
+		}
+		LoadedChunk = ChunkIndex;
+	}
+	return int64(Frame % FramesPerChunk) * GetFrameSize(SocketNames.Num());
+}
+
+double FSocketReplay::GetFrameTime(int32 Frame)
+{
+	// LoadFrame can reallocate the chunk, so it runs before the data is read
+	const int64 Offset = LoadFrame(Frame);
+	return *reinterpret_cast<const double*>(Chunk.GetData() + Offset);
+}
+
+void FSocketReplay::ReadFrame(int32 Frame, double& OutSampleTime, TArray<FVector>& OutLocations, TArray<FRotator>& OutRotations)
+{
+	const int32 NumSockets = SocketNames.Num();
+	const int64 Offset = LoadFrame(Frame);
+	const double* Values = reinterpret_cast<const double*>(Chunk.GetData() + Offset);
+	OutSampleTime = *Values++;
+	OutLocations.SetNumUninitialized(NumSockets, false);
+	OutRotations.SetNumUninitialized(NumSockets, false);
+	for (int32 i = 0; i < NumSockets; i++)
+	{
+		OutLocations[i] = FVector(Values[0], Values[1], Values[2]);
+		OutRotations[i] = FRotator(Values[3], Values[4], Values[5]);
+		Values += 6;
+	}
+}
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/*
+	Socket recordings store every frame of raw socket transforms with the time
+	it was sampled, so a performance can be fed back through the pipeline
+	exactly as it was captured.
+
+	A file starts with a header naming the sockets, followed by chunks of
+	FramesPerChunk frames. Each chunk is zlib compressed on its own, so a reader
+	only inflates the chunk it needs and a recording cut short keeps every
+	chunk written before the cut. A frame is its time followed by the location
+	and rotation of every socket, all as doubles.
+*/
+class PARTICLEOUTPUT_API FSocketRecorder
+{
+public:
+	~FSocketRecorder();
+
+	// Creates Filename and writes the header. Returns false if the file cannot be opened
+	bool Begin(const FString& Filename, const TArray<FName>& SocketNames, int32 FramesPerChunk = 64);
+
+	// Adds one frame. Full chunks are compressed and written by a background task
+	void AddFrame(double SampleTime, const TArray<FVector>& Locations, const TArray<FRotator>& Rotations);
+
+	// Writes the last partial chunk, waits for every write and closes the file
+	void End();
+
+	bool IsRecording() const { return File.IsValid(); }
+
+private:
+	// Hands the current chunk to a write task, chained after the previous one so chunks stay in order
+	void FlushChunk();
+
+	TSharedPtr<IFileHandle, ESPMode::ThreadSafe> File;
+	int32 NumSockets = 0;
+	int32 FramesPerChunk = 0;
+
+	TArray<uint8> Chunk;
+	int32 NumChunkFrames = 0;
+
+	UE::Tasks::FTask WriteTask;
+};
+
+/*
+	Reads a socket recording through a memory mapping of the file. Opening
+	only walks the chunk headers, a chunk is decompressed the first time one
+	of its frames is read and kept until a frame of another chunk is needed.
+*/
+class PARTICLEOUTPUT_API FSocketReplay
+{
+public:
+	~FSocketReplay();
+
+	// Maps Filename and indexes its chunks. Returns false if it is not a readable recording
+	bool Open(const FString& Filename);
+
+	void Close();
+
+	bool IsOpen() const { return Region != nullptr; }
+
+	const TArray<FName>& GetSocketNames() const { return SocketNames; }
+
+	int32 Num() const { return NumFrames; }
+
+	// Time Frame was sampled at when it was recorded
+	double GetFrameTime(int32 Frame);
+
+	// Time the first frame was sampled at, read once when the recording is opened
+	double GetStartTime() const { return StartTime; }
+
+	// Reads the time and socket transforms of Frame
+	void ReadFrame(int32 Frame, double& OutSampleTime, TArray<FVector>& OutLocations, TArray<FRotator>& OutRotations);
+
+private:
+	// Makes the chunk holding Frame the decompressed one and returns Frame's offset into it
+	int64 LoadFrame(int32 Frame);
+
+	IMappedFileHandle* MappedFile = nullptr;
+	IMappedFileRegion* Region = nullptr;
+
+	TArray<FName> SocketNames;
+	int32 FramesPerChunk = 0;
+	int32 NumFrames = 0;
+	double StartTime = 0.0;
+
+	// Offset of each chunk's compressed data and its sizes
+	TArray<int64> ChunkOffsets;
+	TArray<int32> ChunkCompressedSizes;
+	TArray<int32> ChunkSizes;
+
+	TArray<uint8> Chunk;
+	int32 LoadedChunk = INDEX_NONE;
+};
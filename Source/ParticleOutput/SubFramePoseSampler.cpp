@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubFramePoseSampler.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/AnimSingleNodeInstance.h"
+#include "Animation/AnimationPoseData.h"
+#include "Animation/AttributesRuntime.h"
+#include "BonePose.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Async/ParallelFor.h"
+
+bool FSubFramePoseSampler::Launch(USkeletalMeshComponent* MeshComponent, double PreviousTime, double CurrentTime, const FTransform& PreviousComponentToWorld,
+	const TArray<double>& SampleTimes, const TArray<int32>& InCornerBoneIndices, const TArray<FTransform>& InCornerLocalTransforms)
+{
+	check(IsInGameThread());
+	check(!Task.IsValid());
+	if (MeshComponent == nullptr || MeshComponent->GetAnimationMode() != EAnimationMode::AnimationSingleNode || SampleTimes.Num() == 0) {
+		return false;
+	}
+	UAnimSingleNodeInstance* Instance = MeshComponent->GetSingleNodeInstance();
+	USkeletalMesh* Mesh = MeshComponent->GetSkeletalMeshAsset();
+	const UAnimSequence* PlayingSequence = Instance != nullptr ? Cast<UAnimSequence>(Instance->GetAnimationAsset()) : nullptr;
+	if (PlayingSequence == nullptr || Mesh == nullptr) {
+		return false;
+	}
+
+	// Every bone is required, so any socket can be read from the pose
+	if (BoneContainerAsset.Get() != Mesh) {
+		TArray<FBoneIndexType> RequiredBones;
+		RequiredBones.SetNumUninitialized(Mesh->GetRefSkeleton().GetNum());
+		for (int32 i = 0; i < RequiredBones.Num(); i++)
+		{
+			RequiredBones[i] = FBoneIndexType(i);
+		}
+		BoneContainer.InitializeTo(RequiredBones, FCurveEvaluationOption(false), *Mesh);
+		BoneContainerAsset = Mesh;
+	}
+
+	// Step back from this frame's animation position at the play rate, and blend the component's
+	// placement between the two frames
+	const double PlayRate = Instance->IsPlaying() ? Instance->GetPlayRate() : 0.0;
+	const double Length = PlayingSequence->GetPlayLength();
+	const FTransform& CurrentComponentToWorld = MeshComponent->GetComponentTransform();
+	AnimationTimes.SetNumUninitialized(SampleTimes.Num(), false);
+	ComponentToWorlds.SetNumUninitialized(SampleTimes.Num(), false);
+	for (int32 Sample = 0; Sample < SampleTimes.Num(); Sample++)
+	{
+		double Time = Instance->GetCurrentTime() - (CurrentTime - SampleTimes[Sample]) * PlayRate;
+		if (Instance->IsLooping() && Length > 0.0) {
+			Time = FMath::Fmod(Time, Length);
+			Time = Time < 0.0 ? Time + Length : Time;
+		}
+		else {
+			Time = FMath::Clamp(Time, 0.0, Length);
+		}
+		AnimationTimes[Sample] = Time;
+
+		const double Alpha = CurrentTime > PreviousTime ? (SampleTimes[Sample] - PreviousTime) / (CurrentTime - PreviousTime) : 1.0;
+		ComponentToWorlds[Sample].Blend(PreviousComponentToWorld, CurrentComponentToWorld, float(FMath::Clamp(Alpha, 0.0, 1.0)));
+	}
+
+	Sequence = PlayingSequence;
+	CornerBoneIndices = InCornerBoneIndices;
+	CornerLocalTransforms = InCornerLocalTransforms;
+	Corners.SetNumUninitialized(SampleTimes.Num() * CornerBoneIndices.Num(), false);
+
+	// The caller waits in Finish before anything the task reads can change
+	Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]()
+	{
+		ParallelFor(AnimationTimes.Num(), [this](int32 Sample)
+		{
+			FCompactPose Pose;
+			Pose.SetBoneContainer(&BoneContainer);
+			FBlendedCurve Curve;
+			Curve.InitFrom(BoneContainer);
+			UE::Anim::FStackAttributeContainer Attributes;
+			FAnimationPoseData PoseData(Pose, Curve, Attributes);
+			Sequence->GetAnimationPose(PoseData, FAnimExtractContext(AnimationTimes[Sample]));
+
+			FCSPose<FCompactPose> ComponentPose;
+			ComponentPose.InitPose(Pose);
+
+			const int32 NumCorners = CornerBoneIndices.Num();
+			for (int32 Corner = 0; Corner < NumCorners; Corner++)
+			{
+				const int32 BoneIndex = CornerBoneIndices[Corner];
+				const FCompactPoseBoneIndex CompactIndex = BoneIndex != INDEX_NONE ? BoneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(BoneIndex)) : FCompactPoseBoneIndex(INDEX_NONE);
+				const FTransform BoneTransform = CompactIndex.IsValid() ? ComponentPose.GetComponentSpaceTransform(CompactIndex) : FTransform::Identity;
+				Corners[Sample * NumCorners + Corner] = (CornerLocalTransforms[Corner] * BoneTransform * ComponentToWorlds[Sample]).GetLocation();
+			}
+		});
+	});
+	return true;
+}
+
+const TArray<FVector>& FSubFramePoseSampler::Finish()
+{
+	if (Task.IsValid()) {
+		Task.Wait();
+		Task = UE::Tasks::FTask();
+	}
+	return Corners;
+}
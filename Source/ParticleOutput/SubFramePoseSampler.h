@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneContainer.h"
+#include "Tasks/Task.h"
+
+class USkeletalMeshComponent;
+class UAnimSequence;
+
+/*
+	Evaluates a skeletal mesh's animation at times between rendered frames, so
+	socket locations can be sampled at a higher rate than the game ticks. The
+	pose is read straight from the animation sequence the mesh is playing in
+	single node mode and evaluated on a worker task, one pose per sample time,
+	while the game thread carries on with the rest of the frame.
+
+	Animation blueprints can only be evaluated by their own instance on the
+	game thread, so meshes driven by one are not sampled.
+*/
+class PARTICLEOUTPUT_API FSubFramePoseSampler
+{
+public:
+	// Starts evaluating the corner sockets at each of SampleTimes, which lie between the previous
+	// frame at PreviousTime and this one. Returns false, launching nothing, when the mesh is not
+	// playing a single animation sequence. The mesh's pose this frame is taken to be at CurrentTime.
+	// Game thread only, as the mesh and its anim instance are read here
+	bool Launch(USkeletalMeshComponent* MeshComponent, double PreviousTime, double CurrentTime, const FTransform& PreviousComponentToWorld,
+		const TArray<double>& SampleTimes, const TArray<int32>& CornerBoneIndices, const TArray<FTransform>& CornerLocalTransforms);
+
+	// Waits for the launched samples and returns their world space corners, one block of
+	// GetNumCorners() per sample time
+	const TArray<FVector>& Finish();
+
+	bool IsRunning() const { return Task.IsValid(); }
+
+	int32 GetNumCorners() const { return CornerBoneIndices.Num(); }
+
+private:
+	// Required bones of the mesh the bone container was built for, rebuilt when the mesh changes
+	FBoneContainer BoneContainer;
+	TWeakObjectPtr<UObject> BoneContainerAsset;
+
+	// Inputs copied at launch, so the task never reads the mesh
+	const UAnimSequence* Sequence = nullptr;
+	TArray<double> AnimationTimes;
+	TArray<FTransform> ComponentToWorlds;
+	TArray<int32> CornerBoneIndices;
+	TArray<FTransform> CornerLocalTransforms;
+
+	TArray<FVector> Corners;
+	UE::Tasks::FTask Task;
+};
@@ -1,203 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
 #include "TauBuffer.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "ParticleGenerator.h"
 
 // Sets default values for this component's properties
 UTauBuffer::UTauBuffer()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
-	IsGrowing = false;
-	MeasuringStick = FVector(0);
-	BeginningPosition = FVector(0);
-	EndingPosition = FVector(0);
-
-	MotionPath.Emplace(BeginningPosition);
-
-	BeginningTime = FApp::GetCurrentTime();
-	LastReadingTime = FApp::GetCurrentTime();
-	CurrentTime = FApp::GetCurrentTime();
-
-	ElapsedSinceLastReadingTime = 0;
-	ElapsedSinceBeginningGestureTime = 0;
+	// The bank is updated by the generator, so the view has nothing to do per frame
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
-
-// Called when the game starts
-void UTauBuffer::BeginPlay()
+void UTauBuffer::Bind(AParticleGenerator* InGenerator, int32 InTriangleIndex)
 {
-	Super::BeginPlay();
-
+	Generator = InGenerator;
+	TriangleIndex = InTriangleIndex;
 }
 
-
-// Called every frame
-void UTauBuffer::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+const FTauStateBank* UTauBuffer::GetBank() const
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	// ...
+	const AParticleGenerator* Owner = Generator.Get();
+	if (Owner == nullptr || !Owner->GetTauStates().MeasuringStick.IsValidIndex(TriangleIndex)) {
+		return nullptr;
+	}
+	return &Owner->GetTauStates();
 }
 
-void UTauBuffer::CalculateIncrementalGestureChange()
+bool UTauBuffer::GetIsGrowing() const
 {
-	if (MotionPath.Num() < 1) {
-		IncrementalGestureAngleChanges.Emplace(0);
-		return;
-	}
-
-	FVector BeginningNormal = MotionPath[MotionPath.Num()-2];
-	FVector EndingNormal = EndingPosition;
-
-	BeginningNormal.Normalize();
-	EndingNormal.Normalize();
-
-	float CurrentGestureDotProduct = FVector::DotProduct(BeginningNormal, EndingNormal);
-	float AngleChange = UKismetMathLibrary::Acos(CurrentGestureDotProduct);
-	IncrementalGestureAngleChanges.Emplace(AngleChange);
-
-	if (IncrementalGestureAngleChanges.Num() >= 2) {
-		double EndAngle = IncrementalGestureAngleChanges.Last();
-		double CheckAngle = IncrementalGestureAngleChanges.Last(1);
-
-		double EndTime = CurrentTime;
-		double CheckTime = LastReadingTime;
-
-		if (EndTime - CheckTime > 0 && EndAngle - CheckAngle != 0) {
-			double angleChange = EndAngle - CheckAngle;
-			double velocity = angleChange / (EndTime - CheckTime);
-			double IncrementalTau = 3.14159 / velocity;
-			IncrementalTauSamples.Emplace(IncrementalTau);
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Tau: %f"), IncrementalTau);
-		}
-	}
-
-	if (IncrementalTauSamples.Num() > 2) {
-		double EndTau = IncrementalTauSamples.Last();
-		double CheckTau = IncrementalTauSamples.Last(1);
-
-		double EndTime = CurrentTime;
-		double CheckTime = LastReadingTime;
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->IsGrowing[TriangleIndex] : false;
+}
 
-		if (EndTime - CheckTime > 0) {
-			double IncrementalTauDot = (EndTau - CheckTau);
-			IncrementalTauDotSamples.Emplace(IncrementalTauDot);
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Tau Dot: %f"), IncrementalTauDot);
-		}
-	}
+bool UTauBuffer::GetFullGestureIsGrowing() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->FullGestureIsGrowing[TriangleIndex] : false;
+}
 
-	if (IncrementalTauDotSamples.Num() > 4) {
-		double EndTau = IncrementalTauDotSamples.Last();
-		double ThirdTau = IncrementalTauDotSamples.Last(1);
-		double SecondTau = IncrementalTauDotSamples.Last(2);
+FVector UTauBuffer::GetMeasuringStick() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->MeasuringStick[TriangleIndex] : FVector::ZeroVector;
+}
 
-		double SecondMean = (EndTau + ThirdTau) / 2;
-		double FirstMean = (ThirdTau + SecondTau) / 2;
-		double Diff = SecondMean - FirstMean;
-		IncrementalTauDotSmoothedDiffFromLastFrame.Emplace(Diff);
+FVector4 UTauBuffer::GetBeginningPosition() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->BeginningPosition[TriangleIndex] : FVector4(0, 0, 0, 0);
+}
 
-		//UE_LOG(LogTemp, Display, TEXT("Incremental Tau Dot Smoothed Mean: %f"), SecondMean);
-	}
+FVector4 UTauBuffer::GetEndingPosition() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->EndingPosition[TriangleIndex] : FVector4(0, 0, 0, 0);
+}
 
-	if (IncrementalTauDotSmoothedDiffFromLastFrame.Num() > 2) {
-		double EndDiff = IncrementalTauDotSmoothedDiffFromLastFrame.Last();
-		double CheckDiff = IncrementalTauDotSmoothedDiffFromLastFrame.Last(1);
-		if( abs(EndDiff - CheckDiff) < EndDiff * 0.15) {
-			//UE_LOG(LogTemp, Display, TEXT("Incremental Diff is constant:\t%f\t%f"), EndDiff, CheckDiff);
-		}
-		else 
-		{
-			//UE_LOG(LogTemp, Display, TEXT("Diff is NOT constant:\t%f\t%f"), EndDiff, CheckDiff);
-		}
-
-		if (EndDiff - CheckDiff < 0) {
-			IsGrowing = false;
-		}
-		else {
-			IsGrowing = true;
-		}
-
-		//UE_LOG(LogTemp, Display, TEXT("Incremental Is Growing:\t%d"), IsGrowing);
-	}
+TArray<FVector4> UTauBuffer::GetMotionPath() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->MotionPath.ToArray(TriangleIndex) : TArray<FVector4>();
 }
 
-void UTauBuffer::CalculateFullGestureChange()
+TArray<FVector4> UTauBuffer::GetCoarseMotionPath() const
 {
-	if (MotionPath.Num() < 1) {
-		FullGestureAngleChanges.Emplace(0);
-		return;
-	}
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->CoarseMotionPath.ToArray(TriangleIndex) : TArray<FVector4>();
+}
 
-	FVector BeginningNormal = BeginningPosition;
-	FVector EndingNormal = EndingPosition;
+TArray<double> UTauBuffer::GetIncrementalTauSamples() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->IncrementalTauSamples.ToArray(TriangleIndex) : TArray<double>();
+}
 
-	BeginningNormal.Normalize();
-	EndingNormal.Normalize();
+TArray<double> UTauBuffer::GetFullGestureTauSamples() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->FullGestureTauSamples.ToArray(TriangleIndex) : TArray<double>();
+}
 
-	float CurrentGestureDotProduct = FVector::DotProduct(BeginningNormal, EndingNormal);
-	float AngleChange = UKismetMathLibrary::Acos(CurrentGestureDotProduct);
-	FullGestureAngleChanges.Emplace(AngleChange);
+TArray<float> UTauBuffer::GetIncrementalTauDotSamples() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->IncrementalTauDotSamples.ToArray(TriangleIndex) : TArray<float>();
+}
 
-	if (FullGestureAngleChanges.Num() >= 2) {
-		double EndAngle = FullGestureAngleChanges.Last();
-		double CheckAngle = 0;
+TArray<float> UTauBuffer::GetFullGestureTauDotSamples() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->FullGestureTauDotSamples.ToArray(TriangleIndex) : TArray<float>();
+}
 
-		double IncrementalEndAngle = IncrementalGestureAngleChanges.Last();
-		double IncrementalCheckAngle = IncrementalGestureAngleChanges.Last(1);
+TArray<float> UTauBuffer::GetIncrementalTauDotSmoothedDiffFromLastFrame() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->IncrementalTauDotSmoothedDiffFromLastFrame.ToArray(TriangleIndex) : TArray<float>();
+}
 
-		double EndTime = CurrentTime;
-		double CheckTime = LastReadingTime;
-		if (EndTime - CheckTime > 0  && EndAngle - CheckAngle  > 0) {
-			double Distance = (EndAngle - CheckAngle);
-			double RateOfClosure = ((IncrementalEndAngle - IncrementalCheckAngle) / (EndTime - CheckTime));
-			double FullGestureTau = 3.14159 / RateOfClosure ;
-			FullGestureTauSamples.Emplace(FullGestureTau);
-		}
-	}
+TArray<float> UTauBuffer::GetFullGestureTauDotSmoothedDiffFromLastFrame() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->FullGestureTauDotSmoothedDiffFromLastFrame.ToArray(TriangleIndex) : TArray<float>();
+}
 
-	if (FullGestureTauSamples.Num() > 2) {
-		double EndTau = FullGestureTauSamples.Last();
-		double CheckTau = FullGestureTauSamples.Last(1);
+double UTauBuffer::GetIncrementalTauEstimate() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->IncrementalTauEstimate[TriangleIndex] : 0.0;
+}
 
-		double EndTime = CurrentTime;
-		double CheckTime = LastReadingTime;
+double UTauBuffer::GetFullGestureTauEstimate() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->FullGestureTauEstimate[TriangleIndex] : 0.0;
+}
 
-		if (EndTime - CheckTime > 0) {
-			double FullGestureTauDot = (EndTau - CheckTau);
-			FullGestureTauDotSamples.Emplace(FullGestureTauDot);
-		}
-	}
+float UTauBuffer::GetIncrementalTauDotConfidence() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->IncrementalTauDotConfidence[TriangleIndex] : 0.0f;
+}
 
+float UTauBuffer::GetFullGestureTauDotConfidence() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->FullGestureTauDotConfidence[TriangleIndex] : 0.0f;
+}
 
-	if (FullGestureTauDotSamples.Num() > 4) {
-		double EndTau = FullGestureTauDotSamples.Last();
-		double ThirdTau = FullGestureTauDotSamples.Last(1);
-		double SecondTau = FullGestureTauDotSamples.Last(2);
+double UTauBuffer::GetBeginningTime() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->BeginningTime[TriangleIndex] : 0.0;
+}
 
-		double SecondMean = (EndTau + ThirdTau) / 2;
-		double FirstMean = (ThirdTau + SecondTau) / 2;
-		double Diff = SecondMean - FirstMean;
-		FullGestureTauDotSmoothedDiffFromLastFrame.Emplace(Diff);
-		//UE_LOG(LogTemp, Display, TEXT("FullGesture Tau Dot Smoothed Mean: %f"), SecondMean);
-	}
+double UTauBuffer::GetLastReadingTime() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->LastReadingTime[TriangleIndex] : 0.0;
+}
 
-	if (FullGestureTauDotSmoothedDiffFromLastFrame.Num() > 2) {
-		double EndDiff = FullGestureTauDotSmoothedDiffFromLastFrame.Last();
-		double CheckDiff = FullGestureTauDotSmoothedDiffFromLastFrame.Last(1);
-		if (abs(EndDiff - CheckDiff) < EndDiff * 0.15) {
-			//UE_LOG(LogTemp, Display, TEXT("Full Gesture Diff is constant:\t%f\t$f"),EndDiff, CheckDiff);
-		}
-		else {
-			//UE_LOG(LogTemp, Display, TEXT("Full Gesture Diff is NOT constant:\t%f\t$f"), EndDiff, CheckDiff);
-		}
-
-		if (EndDiff - CheckDiff < 0) {
-			FullGestureIsGrowing = false;
-		}
-		else {
-			FullGestureIsGrowing = true;
-		}
-
-		//UE_LOG(LogTemp, Display, TEXT("Full Gesture Is Growing:\t%d"), FullGestureIsGrowing);
-	}
-} 
\ No newline at end of file
+double UTauBuffer::GetElapsedSinceBeginningGestureTime() const
+{
+	const FTauStateBank* Bank = GetBank();
+	return Bank != nullptr ? Bank->ElapsedSinceBeginningGestureTime[TriangleIndex] : 0.0;
+}
@@ -6,9 +6,17 @@
 #include "Components/ActorComponent.h"
 #include "Math/Vector4.h"
 #include "Math/Vector.h"
+#include "TauStateBank.h"
 #include "TauBuffer.generated.h"
 
+class AParticleGenerator;
 
+/*
+	Blueprint view of one triangle's tau state. The state itself lives in the
+	owning AParticleGenerator's FTauStateBank; the view holds no data of its own
+	and never ticks. It only keeps a weak pointer to the generator, so a view
+	that outlives it reads as unbound rather than reading a freed bank.
+*/
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class PARTICLEOUTPUT_API UTauBuffer : public UActorComponent
 {
@@ -18,78 +26,80 @@ public:
 	// Sets default values for this component's properties
 	UTauBuffer();
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	bool IsGrowing;
+	// Points the view at one triangle of the generator's tau states
+	void Bind(AParticleGenerator* InGenerator, int32 InTriangleIndex);
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	bool FullGestureIsGrowing;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	int32 GetTriangleIndex() const { return TriangleIndex; }
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	FVector MeasuringStick;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	bool GetIsGrowing() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	FVector4 BeginningPosition;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	bool GetFullGestureIsGrowing() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	FVector4 EndingPosition;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	FVector GetMeasuringStick() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	TArray<FVector4> MotionPath;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	FVector4 GetBeginningPosition() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	TArray<float> FullGestureAngleChanges;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	FVector4 GetEndingPosition() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	TArray<float> IncrementalGestureAngleChanges;
-	
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	TArray<double> IncrementalTauSamples;
+	// Recent readings of the Euler line, oldest first. W is the reading time
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<FVector4> GetMotionPath() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	TArray<double> FullGestureTauSamples;
+	// Downsampled readings older than the motion path, oldest first
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<FVector4> GetCoarseMotionPath() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
-	TArray<float> IncrementalTauDotSamples;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<double> GetIncrementalTauSamples() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
-	TArray<float> FullGestureTauDotSamples;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<double> GetFullGestureTauSamples() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
-	TArray<float> IncrementalTauDotSmoothedDiffFromLastFrame;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<float> GetIncrementalTauDotSamples() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "ParticleGenerator")
-	TArray<float> FullGestureTauDotSmoothedDiffFromLastFrame;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<float> GetFullGestureTauDotSamples() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	double BeginningTime;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<float> GetIncrementalTauDotSmoothedDiffFromLastFrame() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	double LastReadingTime;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	TArray<float> GetFullGestureTauDotSmoothedDiffFromLastFrame() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	double CurrentTime;
+	// Newest tau after smoothing by the bank's derivative estimator
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	double GetIncrementalTauEstimate() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	double ElapsedSinceLastReadingTime;
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	double GetFullGestureTauEstimate() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "TauBuffer")
-	double ElapsedSinceBeginningGestureTime;
+	// How sure the estimator is of the sign of the newest tau dot, from 0 to 1
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	float GetIncrementalTauDotConfidence() const;
 
-	UFUNCTION(BlueprintCallable, Category = "TauBuffer")
-	void CalculateIncrementalGestureChange();
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	float GetFullGestureTauDotConfidence() const;
 
-	UFUNCTION(BlueprintCallable, Category = "TauBuffer")
-	void CalculateFullGestureChange();
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	double GetBeginningTime() const;
 
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	double GetLastReadingTime() const;
 
+	UFUNCTION(BlueprintPure, Category = "TauBuffer")
+	double GetElapsedSinceBeginningGestureTime() const;
 
-protected:
-	// Called when the game starts
-	virtual void BeginPlay() override;
+private:
+	// The bound generator's bank, or null when the generator is gone or no longer has the triangle
+	const FTauStateBank* GetBank() const;
 
-public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-
-		
+	TWeakObjectPtr<AParticleGenerator> Generator;
+	int32 TriangleIndex = INDEX_NONE;
 };
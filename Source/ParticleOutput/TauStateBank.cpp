@@ -0,0 +1,668 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TauStateBank.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Math/VectorRegister.h"
+
+// atan2 coefficients of an odd polynomial in the ratio of the smaller to the larger of |X| and Y
+#define FAST_ANGLE_C0 -0.013480470
+#define FAST_ANGLE_C1 0.057477314
+#define FAST_ANGLE_C2 -0.121239071
+#define FAST_ANGLE_C3 0.195635925
+#define FAST_ANGLE_C4 -0.332994597
+#define FAST_ANGLE_C5 0.999995630
+
+// atan2(Y, X) for Y >= 0 by the polynomial. The vector version below performs the same operations
+// in the same order without fusing any, so both give identical results
+static FORCEINLINE double FastAtan2(double Y, double X)
+{
+	const double AbsX = FMath::Abs(X);
+	const double Larger = FMath::Max(AbsX, Y);
+	const double Smaller = FMath::Min(AbsX, Y);
+	const double Ratio = Larger > 0.0 ? Smaller / Larger : 0.0;
+	const double Squared = Ratio * Ratio;
+
+	double Poly = FAST_ANGLE_C0;
+	Poly = Poly * Squared + FAST_ANGLE_C1;
+	Poly = Poly * Squared + FAST_ANGLE_C2;
+	Poly = Poly * Squared + FAST_ANGLE_C3;
+	Poly = Poly * Squared + FAST_ANGLE_C4;
+	Poly = Poly * Squared + FAST_ANGLE_C5;
+
+	double Angle = Poly * Ratio;
+	Angle = Y > AbsX ? UE_DOUBLE_HALF_PI - Angle : Angle;
+	return X < 0.0 ? UE_DOUBLE_PI - Angle : Angle;
+}
+
+static FORCEINLINE VectorRegister4Double FastAtan2(VectorRegister4Double Y, VectorRegister4Double X)
+{
+	const VectorRegister4Double Zero = VectorZeroDouble();
+	const VectorRegister4Double AbsX = VectorAbs(X);
+	const VectorRegister4Double Larger = VectorMax(AbsX, Y);
+	const VectorRegister4Double Smaller = VectorMin(AbsX, Y);
+	const VectorRegister4Double Ratio = VectorSelect(VectorCompareGT(Larger, Zero), VectorDivide(Smaller, Larger), Zero);
+	const VectorRegister4Double Squared = VectorMultiply(Ratio, Ratio);
+
+	VectorRegister4Double Poly = VectorSetFloat1(FAST_ANGLE_C0);
+	Poly = VectorAdd(VectorMultiply(Poly, Squared), VectorSetFloat1(FAST_ANGLE_C1));
+	Poly = VectorAdd(VectorMultiply(Poly, Squared), VectorSetFloat1(FAST_ANGLE_C2));
+	Poly = VectorAdd(VectorMultiply(Poly, Squared), VectorSetFloat1(FAST_ANGLE_C3));
+	Poly = VectorAdd(VectorMultiply(Poly, Squared), VectorSetFloat1(FAST_ANGLE_C4));
+	Poly = VectorAdd(VectorMultiply(Poly, Squared), VectorSetFloat1(FAST_ANGLE_C5));
+
+	VectorRegister4Double Angle = VectorMultiply(Poly, Ratio);
+	Angle = VectorSelect(VectorCompareGT(Y, AbsX), VectorSubtract(VectorSetFloat1(UE_DOUBLE_HALF_PI), Angle), Angle);
+	return VectorSelect(VectorCompareGT(Zero, X), VectorSubtract(VectorSetFloat1(UE_DOUBLE_PI), Angle), Angle);
+}
+
+// |A x B| and A . B of four pairs of vectors, with the operations of FVector::CrossProduct,
+// Size and DotProduct in the same order and unfused, so the results match them bit for bit
+static FORCEINLINE void CrossDot4(
+	const double* AX, const double* AY, const double* AZ,
+	const double* BX, const double* BY, const double* BZ,
+	VectorRegister4Double& OutCross, VectorRegister4Double& OutDot)
+{
+	const VectorRegister4Double Ax = VectorLoad(AX);
+	const VectorRegister4Double Ay = VectorLoad(AY);
+	const VectorRegister4Double Az = VectorLoad(AZ);
+	const VectorRegister4Double Bx = VectorLoad(BX);
+	const VectorRegister4Double By = VectorLoad(BY);
+	const VectorRegister4Double Bz = VectorLoad(BZ);
+
+	const VectorRegister4Double Cx = VectorSubtract(VectorMultiply(Ay, Bz), VectorMultiply(Az, By));
+	const VectorRegister4Double Cy = VectorSubtract(VectorMultiply(Az, Bx), VectorMultiply(Ax, Bz));
+	const VectorRegister4Double Cz = VectorSubtract(VectorMultiply(Ax, By), VectorMultiply(Ay, Bx));
+
+	OutCross = VectorSqrt(VectorAdd(VectorAdd(VectorMultiply(Cx, Cx), VectorMultiply(Cy, Cy)), VectorMultiply(Cz, Cz)));
+	OutDot = VectorAdd(VectorAdd(VectorMultiply(Ax, Bx), VectorMultiply(Ay, By)), VectorMultiply(Az, Bz));
+}
+
+double FTauStateBank::GestureAngle(const FVector& A, const FVector& B)
+{
+	return FMath::Atan2(FVector::CrossProduct(A, B).Size(), FVector::DotProduct(A, B));
+}
+
+double FTauStateBank::FastGestureAngle(const FVector& A, const FVector& B)
+{
+	return FastAtan2(FVector::CrossProduct(A, B).Size(), FVector::DotProduct(A, B));
+}
+
+void FTauStateBank::LogAngleAccuracy()
+{
+	// Pairs of random directions a known angle apart, with random lengths, from 1e-7 radians up to pi - 1e-7
+	FRandomStream Random(0x7A0);
+	double MaxAcosError = 0.0;
+	double MaxError = 0.0;
+	double MaxFastError = 0.0;
+	double MaxEndRelativeAcosError = 0.0;
+	double MaxEndRelativeError = 0.0;
+	for (int32 Sample = 0; Sample < 4096; Sample++)
+	{
+		const double Exponent = -7.0 + 7.0 * Sample / 4095.0;
+		const double Offset = FMath::Min(FMath::Pow(10.0, Exponent) * 0.5 * UE_DOUBLE_PI, UE_DOUBLE_HALF_PI);
+		const double Angle = (Sample & 1) ? UE_DOUBLE_PI - Offset : Offset;
+
+		const FVector U = Random.GetUnitVector();
+		const FVector V = FVector::CrossProduct(U, Random.GetUnitVector()).GetSafeNormal();
+		const FVector A = U * Random.FRandRange(1.0, 1000.0);
+		const FVector B = (U * FMath::Cos(Angle) + V * FMath::Sin(Angle)) * Random.FRandRange(1.0, 1000.0);
+
+		// The angle as the tau code used to measure it
+		const float AcosAngle = UKismetMathLibrary::Acos(float(FVector::DotProduct(A.GetSafeNormal(), B.GetSafeNormal())));
+
+		const double AcosError = FMath::Abs(AcosAngle - Angle);
+		const double Error = FMath::Abs(GestureAngle(A, B) - Angle);
+		MaxAcosError = FMath::Max(MaxAcosError, AcosError);
+		MaxError = FMath::Max(MaxError, Error);
+		MaxFastError = FMath::Max(MaxFastError, FMath::Abs(FastGestureAngle(A, B) - Angle));
+
+		// Relative to the distance from the nearest end, so errors where gestures start and stop count fully
+		MaxEndRelativeAcosError = FMath::Max(MaxEndRelativeAcosError, AcosError / Offset);
+		MaxEndRelativeError = FMath::Max(MaxEndRelativeError, Error / Offset);
+	}
+	UE_LOG(LogTemp, Display, TEXT("Gesture angle max error, acos: %g (%g relative)\tatan2: %g (%g relative)\tpolynomial: %g"),
+		MaxAcosError, MaxEndRelativeAcosError, MaxError, MaxEndRelativeError, MaxFastError);
+}
+// Initial variance of a Kalman filter's tau dot, large enough that the first estimate follows the first two samples
+#define KALMAN_INITIAL_TAU_DOT_VARIANCE 1000000.0
+
+// Least squares weights of a polynomial of degree Order through NumSamples evenly spaced samples,
+// the newest at t = 0. Row k of OutWeights gives the coefficient of t^k when dotted with the samples
+static void ComputeSavitzkyGolayWeights(int32 NumSamples, int32 Order, double* OutWeights)
+{
+	const int32 NumTerms = Order + 1;
+	double Normal[4][8] = {};
+	for (int32 Row = 0; Row < NumTerms; Row++)
+	{
+		for (int32 j = 0; j < NumSamples; j++)
+		{
+			const double t = j - (NumSamples - 1);
+			for (int32 Column = 0; Column < NumTerms; Column++)
+			{
+				Normal[Row][Column] += FMath::Pow(t, double(Row + Column));
+			}
+		}
+		Normal[Row][NumTerms + Row] = 1.0;
+	}
+
+	// Invert the normal matrix by Gauss-Jordan elimination with partial pivoting
+	for (int32 Column = 0; Column < NumTerms; Column++)
+	{
+		int32 Pivot = Column;
+		for (int32 Row = Column + 1; Row < NumTerms; Row++)
+		{
+			if (FMath::Abs(Normal[Row][Column]) > FMath::Abs(Normal[Pivot][Column])) {
+				Pivot = Row;
+			}
+		}
+		for (int32 k = 0; k < 2 * NumTerms; k++)
+		{
+			Swap(Normal[Column][k], Normal[Pivot][k]);
+		}
+		const double Scale = 1.0 / Normal[Column][Column];
+		for (int32 k = 0; k < 2 * NumTerms; k++)
+		{
+			Normal[Column][k] *= Scale;
+		}
+		for (int32 Row = 0; Row < NumTerms; Row++)
+		{
+			if (Row != Column) {
+				const double Factor = Normal[Row][Column];
+				for (int32 k = 0; k < 2 * NumTerms; k++)
+				{
+					Normal[Row][k] -= Factor * Normal[Column][k];
+				}
+			}
+		}
+	}
+
+	for (int32 Row = 0; Row < NumTerms; Row++)
+	{
+		for (int32 j = 0; j < NumSamples; j++)
+		{
+			const double t = j - (NumSamples - 1);
+			double Weight = 0.0;
+			for (int32 k = 0; k < NumTerms; k++)
+			{
+				Weight += Normal[Row][NumTerms + k] * FMath::Pow(t, double(k));
+			}
+			OutWeights[Row * NumSamples + j] = Weight;
+		}
+	}
+}
+
+void FTauStateBank::Reset()
+{
+	Begin(TArray<FVector>(), TArray<FVector>(), 0.0);
+}
+
+void FTauStateBank::Begin(const TArray<FVector>& MeasuringSticks, const TArray<FVector>& EulerLines, double Time)
+{
+	check(MeasuringSticks.Num() == EulerLines.Num());
+	const int32 NumTriangles = MeasuringSticks.Num();
+
+	MeasuringStick = MeasuringSticks;
+	BeginningPosition.SetNumUninitialized(NumTriangles);
+	EndingPosition.Init(FVector4(0, 0, 0, 0), NumTriangles);
+
+	// The incremental change reads the reading before the newest, so the window holds at least two
+	MotionPath.Init(NumTriangles, FMath::Max(MotionPathWindow, 2));
+	CoarseMotionPath.Init(NumTriangles, CoarseMotionPathStride > 0 ? CoarseMotionPathWindow : 0);
+	CoarseSums.Init(FVector4(0, 0, 0, 0), NumTriangles);
+	CoarseCounts.Init(0, NumTriangles);
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		BeginningPosition[i] = FVector4(EulerLines[i].X, EulerLines[i].Y, EulerLines[i].Z, 0.0);
+		MotionPath.Add(i, BeginningPosition[i]);
+	}
+
+	IsGrowing.Init(false, NumTriangles);
+	FullGestureIsGrowing.Init(false, NumTriangles);
+
+	BeginningTime.Init(Time, NumTriangles);
+	LastReadingTime.Init(Time, NumTriangles);
+	CurrentTime.Init(Time, NumTriangles);
+	ElapsedSinceLastReadingTime.Init(0.0, NumTriangles);
+	ElapsedSinceBeginningGestureTime.Init(0.0, NumTriangles);
+
+	// The smoothed difference needs the last five tau dot samples
+	const int32 Window = FMath::Max(SampleWindow, 5);
+	IncrementalGestureAngleChanges.Init(NumTriangles, Window);
+	FullGestureAngleChanges.Init(NumTriangles, Window);
+	IncrementalTauSamples.Init(NumTriangles, Window);
+	FullGestureTauSamples.Init(NumTriangles, Window);
+	IncrementalTauDotSamples.Init(NumTriangles, Window);
+	FullGestureTauDotSamples.Init(NumTriangles, Window);
+	IncrementalTauDotSmoothedDiffFromLastFrame.Init(NumTriangles, Window);
+	FullGestureTauDotSmoothedDiffFromLastFrame.Init(NumTriangles, Window);
+
+	const float InitialConfidence = DerivativeEstimator == ETauDerivativeEstimator::Difference ? 1.0f : 0.0f;
+	IncrementalTauEstimate.Init(0.0, NumTriangles);
+	FullGestureTauEstimate.Init(0.0, NumTriangles);
+	IncrementalTauDotConfidence.Init(InitialConfidence, NumTriangles);
+	FullGestureTauDotConfidence.Init(InitialConfidence, NumTriangles);
+	IncrementalKalman.Init(FTauKalmanState(), NumTriangles);
+	FullGestureKalman.Init(FTauKalmanState(), NumTriangles);
+
+	// A fit needs at least one more sample than it has terms to estimate its own error
+	EstimatorSettings.SavitzkyGolayOrder = FMath::Clamp(EstimatorSettings.SavitzkyGolayOrder, 1, 3);
+	EstimatorSettings.SavitzkyGolayWindow = FMath::Clamp(EstimatorSettings.SavitzkyGolayWindow, EstimatorSettings.SavitzkyGolayOrder + 2, Window);
+	SavitzkyGolayWeights.Reset();
+	SavitzkyGolayOffsets.Init(INDEX_NONE, EstimatorSettings.SavitzkyGolayWindow + 1);
+	const int32 NumTerms = EstimatorSettings.SavitzkyGolayOrder + 1;
+	for (int32 NumSamples = NumTerms + 1; NumSamples <= EstimatorSettings.SavitzkyGolayWindow; NumSamples++)
+	{
+		SavitzkyGolayOffsets[NumSamples] = SavitzkyGolayWeights.Num();
+		SavitzkyGolayWeights.AddUninitialized(NumTerms * NumSamples);
+		ComputeSavitzkyGolayWeights(NumSamples, EstimatorSettings.SavitzkyGolayOrder, &SavitzkyGolayWeights[SavitzkyGolayOffsets[NumSamples]]);
+	}
+}
+
+void FTauStateBank::AddReadings(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time)
+{
+	Readings.Reset(Triangles.Num());
+	for (int32 i : Triangles)
+	{
+		if (!MeasuringStick.IsValidIndex(i)) {
+			continue;
+		}
+		Readings.Add(i);
+
+		CurrentTime[i] = Time;
+		ElapsedSinceLastReadingTime[i] = Time - LastReadingTime[i];
+		ElapsedSinceBeginningGestureTime[i] = Time - BeginningTime[i];
+
+		const FVector& EulerLine = EulerLines[i];
+		EndingPosition[i] = FVector4(EulerLine.X, EulerLine.Y, EulerLine.Z, Time);
+		AddToMotionPath(i, EndingPosition[i]);
+	}
+}
+
+void FTauStateBank::Update(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time)
+{
+	AddReadings(Triangles, EulerLines, Time);
+	const int32 NumReadings = Readings.Num();
+
+	// Gather the three directions of every reading into one array per component
+	for (TArray<double>* Component : { &PreviousX, &PreviousY, &PreviousZ, &EndingX, &EndingY, &EndingZ, &BeginningX, &BeginningY, &BeginningZ })
+	{
+		Component->SetNumUninitialized(NumReadings, false);
+	}
+	for (int32 Reading = 0; Reading < NumReadings; Reading++)
+	{
+		const int32 i = Readings[Reading];
+		const FVector4& Previous = GetPreviousReading(i);
+		PreviousX[Reading] = Previous.X;
+		PreviousY[Reading] = Previous.Y;
+		PreviousZ[Reading] = Previous.Z;
+		EndingX[Reading] = EndingPosition[i].X;
+		EndingY[Reading] = EndingPosition[i].Y;
+		EndingZ[Reading] = EndingPosition[i].Z;
+		BeginningX[Reading] = BeginningPosition[i].X;
+		BeginningY[Reading] = BeginningPosition[i].Y;
+		BeginningZ[Reading] = BeginningPosition[i].Z;
+	}
+
+	// Cross product lengths and dot products, four readings per register. The polynomial
+	// turns them into angles in the same registers, atan2 is called per reading
+	IncrementalAngles.SetNumUninitialized(NumReadings, false);
+	FullGestureAngles.SetNumUninitialized(NumReadings, false);
+	VectorRegister4Double IncrementalCross, IncrementalDot, FullGestureCross, FullGestureDot;
+	int32 Reading = 0;
+	for (; Reading + 4 <= NumReadings; Reading += 4)
+	{
+		CrossDot4(&PreviousX[Reading], &PreviousY[Reading], &PreviousZ[Reading], &EndingX[Reading], &EndingY[Reading], &EndingZ[Reading], IncrementalCross, IncrementalDot);
+		CrossDot4(&BeginningX[Reading], &BeginningY[Reading], &BeginningZ[Reading], &EndingX[Reading], &EndingY[Reading], &EndingZ[Reading], FullGestureCross, FullGestureDot);
+		if (bFastAngle) {
+			VectorStore(FastAtan2(IncrementalCross, IncrementalDot), &IncrementalAngles[Reading]);
+			VectorStore(FastAtan2(FullGestureCross, FullGestureDot), &FullGestureAngles[Reading]);
+			continue;
+		}
+
+		double Cross[4], Dot[4];
+		VectorStore(IncrementalCross, Cross);
+		VectorStore(IncrementalDot, Dot);
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			IncrementalAngles[Reading + Lane] = FMath::Atan2(Cross[Lane], Dot[Lane]);
+		}
+		VectorStore(FullGestureCross, Cross);
+		VectorStore(FullGestureDot, Dot);
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			FullGestureAngles[Reading + Lane] = FMath::Atan2(Cross[Lane], Dot[Lane]);
+		}
+	}
+	for (; Reading < NumReadings; Reading++)
+	{
+		const FVector Previous(PreviousX[Reading], PreviousY[Reading], PreviousZ[Reading]);
+		const FVector Ending(EndingX[Reading], EndingY[Reading], EndingZ[Reading]);
+		const FVector Beginning(BeginningX[Reading], BeginningY[Reading], BeginningZ[Reading]);
+		IncrementalAngles[Reading] = bFastAngle ? FastGestureAngle(Previous, Ending) : GestureAngle(Previous, Ending);
+		FullGestureAngles[Reading] = bFastAngle ? FastGestureAngle(Beginning, Ending) : GestureAngle(Beginning, Ending);
+	}
+
+	// The tau chain depends on each triangle's own history
+	for (int32 j = 0; j < NumReadings; j++)
+	{
+		const int32 i = Readings[j];
+		UpdateIncrementalGestureChange(i, float(IncrementalAngles[j]));
+		UpdateFullGestureChange(i, float(FullGestureAngles[j]));
+		LastReadingTime[i] = Time;
+	}
+}
+
+void FTauStateBank::UpdateScalar(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time)
+{
+	AddReadings(Triangles, EulerLines, Time);
+	for (int32 i : Readings)
+	{
+		const FVector Previous(GetPreviousReading(i));
+		const FVector Beginning(BeginningPosition[i]);
+		const FVector Ending(EndingPosition[i]);
+		UpdateIncrementalGestureChange(i, float(bFastAngle ? FastGestureAngle(Previous, Ending) : GestureAngle(Previous, Ending)));
+		UpdateFullGestureChange(i, float(bFastAngle ? FastGestureAngle(Beginning, Ending) : GestureAngle(Beginning, Ending)));
+		LastReadingTime[i] = Time;
+	}
+}
+
+double FTauStateBank::UpdateAndValidate(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time, double& OutSeconds, double& OutScalarSeconds)
+{
+	FTauStateBank Reference = *this;
+
+	double StartTime = FPlatformTime::Seconds();
+	Reference.UpdateScalar(Triangles, EulerLines, Time);
+	OutScalarSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	Update(Triangles, EulerLines, Time);
+	OutSeconds = FPlatformTime::Seconds() - StartTime;
+
+	// Compare the newest entry of every history the update touched
+	double MaxDeviation = 0.0;
+	auto Compare = [&MaxDeviation](const auto& Batched, const auto& Scalar, int32 i)
+	{
+		if (Batched.Num(i) != Scalar.Num(i)) {
+			MaxDeviation = TNumericLimits<double>::Max();
+		}
+		else if (Batched.Num(i) > 0) {
+			MaxDeviation = FMath::Max(MaxDeviation, FMath::Abs(double(Batched.Last(i)) - double(Scalar.Last(i))));
+		}
+	};
+	for (int32 i : Readings)
+	{
+		Compare(IncrementalGestureAngleChanges, Reference.IncrementalGestureAngleChanges, i);
+		Compare(FullGestureAngleChanges, Reference.FullGestureAngleChanges, i);
+		Compare(IncrementalTauSamples, Reference.IncrementalTauSamples, i);
+		Compare(FullGestureTauSamples, Reference.FullGestureTauSamples, i);
+		Compare(IncrementalTauDotSamples, Reference.IncrementalTauDotSamples, i);
+		Compare(FullGestureTauDotSamples, Reference.FullGestureTauDotSamples, i);
+		Compare(IncrementalTauDotSmoothedDiffFromLastFrame, Reference.IncrementalTauDotSmoothedDiffFromLastFrame, i);
+		Compare(FullGestureTauDotSmoothedDiffFromLastFrame, Reference.FullGestureTauDotSmoothedDiffFromLastFrame, i);
+	}
+	return MaxDeviation;
+}
+
+void FTauStateBank::AddToMotionPath(int32 i, const FVector4& Reading)
+{
+	FVector4 Evicted;
+	if (!MotionPath.Add(i, Reading, &Evicted) || CoarseMotionPathStride <= 0) {
+		return;
+	}
+
+	CoarseSums[i] += Evicted;
+	if (++CoarseCounts[i] == CoarseMotionPathStride) {
+		CoarseMotionPath.Add(i, CoarseSums[i] * (1.0 / CoarseMotionPathStride));
+		CoarseSums[i] = FVector4(0, 0, 0, 0);
+		CoarseCounts[i] = 0;
+	}
+}
+
+SIZE_T FTauStateBank::GetAllocatedSize() const
+{
+	SIZE_T Size = MeasuringStick.GetAllocatedSize() + BeginningPosition.GetAllocatedSize() + EndingPosition.GetAllocatedSize()
+		+ MotionPath.GetAllocatedSize() + CoarseMotionPath.GetAllocatedSize() + CoarseSums.GetAllocatedSize() + CoarseCounts.GetAllocatedSize()
+		+ IsGrowing.GetAllocatedSize() + FullGestureIsGrowing.GetAllocatedSize()
+		+ BeginningTime.GetAllocatedSize() + LastReadingTime.GetAllocatedSize() + CurrentTime.GetAllocatedSize()
+		+ ElapsedSinceLastReadingTime.GetAllocatedSize() + ElapsedSinceBeginningGestureTime.GetAllocatedSize()
+		+ IncrementalGestureAngleChanges.GetAllocatedSize() + FullGestureAngleChanges.GetAllocatedSize()
+		+ IncrementalTauSamples.GetAllocatedSize() + FullGestureTauSamples.GetAllocatedSize()
+		+ IncrementalTauDotSamples.GetAllocatedSize() + FullGestureTauDotSamples.GetAllocatedSize()
+		+ IncrementalTauDotSmoothedDiffFromLastFrame.GetAllocatedSize() + FullGestureTauDotSmoothedDiffFromLastFrame.GetAllocatedSize()
+		+ IncrementalTauEstimate.GetAllocatedSize() + FullGestureTauEstimate.GetAllocatedSize()
+		+ IncrementalTauDotConfidence.GetAllocatedSize() + FullGestureTauDotConfidence.GetAllocatedSize()
+		+ IncrementalKalman.GetAllocatedSize() + FullGestureKalman.GetAllocatedSize()
+		+ SavitzkyGolayWeights.GetAllocatedSize() + SavitzkyGolayOffsets.GetAllocatedSize();
+	return Size;
+}
+
+const FVector4& FTauStateBank::GetPreviousReading(int32 i) const
+{
+	// Begin seeds every motion path, so this only falls back if a path was emptied since
+	return MotionPath.Num(i) > 1 ? MotionPath.Last(i, 1) : BeginningPosition[i];
+}
+
+void FTauStateBank::UpdateIncrementalGestureChange(int32 i, float AngleChange)
+{
+	// AngleChange is the angle swept since the previous reading
+	TTriangleHistory<float>& AngleChanges = IncrementalGestureAngleChanges;
+	AngleChanges.Add(i, AngleChange);
+
+	const double EndTime = CurrentTime[i];
+	const double CheckTime = LastReadingTime[i];
+
+	TTriangleHistory<double>& TauSamples = IncrementalTauSamples;
+	bool bNewTau = false;
+	if (AngleChanges.Num(i) >= 2) {
+		double EndAngle = AngleChanges.Last(i);
+		double CheckAngle = AngleChanges.Last(i, 1);
+
+		if (EndTime - CheckTime > 0 && EndAngle - CheckAngle != 0) {
+			double angleChange = EndAngle - CheckAngle;
+			double velocity = angleChange / (EndTime - CheckTime);
+			double IncrementalTau = 3.14159 / velocity;
+			TauSamples.Add(i, IncrementalTau);
+			IncrementalTauEstimate[i] = IncrementalTau;
+			bNewTau = true;
+		}
+	}
+
+	if (DerivativeEstimator != ETauDerivativeEstimator::Difference) {
+		if (bNewTau) {
+			EstimateTauDot(i, TauSamples, IncrementalKalman, IncrementalTauEstimate, IncrementalTauDotConfidence,
+				IncrementalTauDotSamples, IncrementalTauDotSmoothedDiffFromLastFrame, IsGrowing);
+		}
+		return;
+	}
+
+	TTriangleHistory<float>& TauDotSamples = IncrementalTauDotSamples;
+	if (TauSamples.Num(i) > 2) {
+		double EndTau = TauSamples.Last(i);
+		double CheckTau = TauSamples.Last(i, 1);
+
+		if (EndTime - CheckTime > 0) {
+			double IncrementalTauDot = (EndTau - CheckTau);
+			TauDotSamples.Add(i, float(IncrementalTauDot));
+		}
+	}
+
+	TTriangleHistory<float>& SmoothedDiffs = IncrementalTauDotSmoothedDiffFromLastFrame;
+	if (TauDotSamples.Num(i) > 4) {
+		double EndTau = TauDotSamples.Last(i);
+		double ThirdTau = TauDotSamples.Last(i, 1);
+		double SecondTau = TauDotSamples.Last(i, 2);
+
+		double SecondMean = (EndTau + ThirdTau) / 2;
+		double FirstMean = (ThirdTau + SecondTau) / 2;
+		double Diff = SecondMean - FirstMean;
+		SmoothedDiffs.Add(i, float(Diff));
+	}
+
+	if (SmoothedDiffs.Num(i) > 2) {
+		double EndDiff = SmoothedDiffs.Last(i);
+		double CheckDiff = SmoothedDiffs.Last(i, 1);
+		IsGrowing[i] = EndDiff - CheckDiff >= 0;
+	}
+}
+
+void FTauStateBank::UpdateFullGestureChange(int32 i, float AngleChange)
+{
+	// AngleChange is the angle swept since the gesture began
+	TTriangleHistory<float>& AngleChanges = FullGestureAngleChanges;
+	AngleChanges.Add(i, AngleChange);
+
+	const double EndTime = CurrentTime[i];
+	const double CheckTime = LastReadingTime[i];
+
+	TTriangleHistory<double>& TauSamples = FullGestureTauSamples;
+	bool bNewTau = false;
+	if (AngleChanges.Num(i) >= 2) {
+		double EndAngle = AngleChanges.Last(i);
+		double CheckAngle = 0;
+
+		double IncrementalEndAngle = IncrementalGestureAngleChanges.Last(i);
+		double IncrementalCheckAngle = IncrementalGestureAngleChanges.Last(i, 1);
+
+		if (EndTime - CheckTime > 0 && EndAngle - CheckAngle > 0) {
+			double RateOfClosure = ((IncrementalEndAngle - IncrementalCheckAngle) / (EndTime - CheckTime));
+			double FullGestureTau = 3.14159 / RateOfClosure;
+			TauSamples.Add(i, FullGestureTau);
+			FullGestureTauEstimate[i] = FullGestureTau;
+			bNewTau = true;
+		}
+	}
+
+	if (DerivativeEstimator != ETauDerivativeEstimator::Difference) {
+		if (bNewTau) {
+			EstimateTauDot(i, TauSamples, FullGestureKalman, FullGestureTauEstimate, FullGestureTauDotConfidence,
+				FullGestureTauDotSamples, FullGestureTauDotSmoothedDiffFromLastFrame, FullGestureIsGrowing);
+		}
+		return;
+	}
+
+	TTriangleHistory<float>& TauDotSamples = FullGestureTauDotSamples;
+	if (TauSamples.Num(i) > 2) {
+		double EndTau = TauSamples.Last(i);
+		double CheckTau = TauSamples.Last(i, 1);
+
+		if (EndTime - CheckTime > 0) {
+			double FullGestureTauDot = (EndTau - CheckTau);
+			TauDotSamples.Add(i, float(FullGestureTauDot));
+		}
+	}
+
+	TTriangleHistory<float>& SmoothedDiffs = FullGestureTauDotSmoothedDiffFromLastFrame;
+	if (TauDotSamples.Num(i) > 4) {
+		double EndTau = TauDotSamples.Last(i);
+		double ThirdTau = TauDotSamples.Last(i, 1);
+		double SecondTau = TauDotSamples.Last(i, 2);
+
+		double SecondMean = (EndTau + ThirdTau) / 2;
+		double FirstMean = (ThirdTau + SecondTau) / 2;
+		double Diff = SecondMean - FirstMean;
+		SmoothedDiffs.Add(i, float(Diff));
+	}
+
+	if (SmoothedDiffs.Num(i) > 2) {
+		double EndDiff = SmoothedDiffs.Last(i);
+		double CheckDiff = SmoothedDiffs.Last(i, 1);
+		FullGestureIsGrowing[i] = EndDiff - CheckDiff >= 0;
+	}
+}
+
+void FTauStateBank::EstimateTauDot(int32 i, const TTriangleHistory<double>& TauSamples, TArray<FTauKalmanState>& Kalman,
+	TArray<double>& TauEstimates, TArray<float>& Confidences, TTriangleHistory<float>& TauDotSamples,
+	TTriangleHistory<float>& SmoothedDiffs, TArray<bool>& Growing)
+{
+	double Tau = 0.0;
+	double TauDot = 0.0;
+	double TauDotError = 0.0;
+
+	if (DerivativeEstimator == ETauDerivativeEstimator::SavitzkyGolay) {
+		// Fit the polynomial to the newest samples and read tau and its slope at the newest one
+		const int32 Order = EstimatorSettings.SavitzkyGolayOrder;
+		const int32 NumSamples = FMath::Min(TauSamples.Num(i), EstimatorSettings.SavitzkyGolayWindow);
+		if (NumSamples < Order + 2) {
+			return;
+		}
+		const double* Weights = &SavitzkyGolayWeights[SavitzkyGolayOffsets[NumSamples]];
+
+		double Coefficients[4] = { 0.0, 0.0, 0.0, 0.0 };
+		for (int32 k = 0; k <= Order; k++)
+		{
+			for (int32 j = 0; j < NumSamples; j++)
+			{
+				Coefficients[k] += Weights[k * NumSamples + j] * TauSamples.Last(i, NumSamples - 1 - j);
+			}
+		}
+		Tau = Coefficients[0];
+		TauDot = Coefficients[1];
+
+		// The spread of the samples around the fit gives the standard error of the slope
+		double ResidualSquares = 0.0;
+		double SlopeWeightSquares = 0.0;
+		for (int32 j = 0; j < NumSamples; j++)
+		{
+			const double t = j - (NumSamples - 1);
+			const double Fit = Coefficients[0] + t * (Coefficients[1] + t * (Coefficients[2] + t * Coefficients[3]));
+			const double Residual = TauSamples.Last(i, NumSamples - 1 - j) - Fit;
+			ResidualSquares += Residual * Residual;
+			SlopeWeightSquares += Weights[NumSamples + j] * Weights[NumSamples + j];
+		}
+		TauDotError = FMath::Sqrt(ResidualSquares / (NumSamples - Order - 1) * SlopeWeightSquares);
+	}
+	else {
+		// Predict one sample ahead at constant tau dot, then correct with the newest sample
+		FTauKalmanState& State = Kalman[i];
+		const double Measurement = TauSamples.Last(i);
+		const double ProcessNoise = EstimatorSettings.KalmanProcessNoise;
+		const double MeasurementNoise = EstimatorSettings.KalmanMeasurementNoise;
+
+		if (!State.bInitialized) {
+			State.Tau = Measurement;
+			State.TauDot = 0.0;
+			State.P00 = MeasurementNoise;
+			State.P01 = 0.0;
+			State.P11 = KALMAN_INITIAL_TAU_DOT_VARIANCE;
+			State.bInitialized = true;
+			TauEstimates[i] = Measurement;
+			return;
+		}
+
+		State.Tau += State.TauDot;
+		State.P00 += 2.0 * State.P01 + State.P11 + 0.25 * ProcessNoise;
+		State.P01 += State.P11 + 0.5 * ProcessNoise;
+		State.P11 += ProcessNoise;
+
+		const double Innovation = Measurement - State.Tau;
+		const double InnovationVariance = State.P00 + MeasurementNoise;
+		if (InnovationVariance > 0.0) {
+			const double TauGain = State.P00 / InnovationVariance;
+			const double TauDotGain = State.P01 / InnovationVariance;
+			State.Tau += TauGain * Innovation;
+			State.TauDot += TauDotGain * Innovation;
+			State.P11 -= TauDotGain * State.P01;
+			State.P00 *= 1.0 - TauGain;
+			State.P01 *= 1.0 - TauGain;
+		}
+
+		Tau = State.Tau;
+		TauDot = State.TauDot;
+		TauDotError = FMath::Sqrt(FMath::Max(State.P11, 0.0));
+	}
+
+	// Confidence in the sign of tau dot, approaching 1 as it grows beyond its standard error
+	const double Denominator = FMath::Abs(TauDot) + TauDotError;
+	TauEstimates[i] = Tau;
+	Confidences[i] = Denominator > 0.0 ? float(FMath::Abs(TauDot) / Denominator) : 0.0f;
+
+	// The estimate is already smoothed, so its change drives IsGrowing directly
+	TauDotSamples.Add(i, float(TauDot));
+	if (TauDotSamples.Num(i) >= 2) {
+		SmoothedDiffs.Add(i, TauDotSamples.Last(i) - TauDotSamples.Last(i, 1));
+	}
+	if (SmoothedDiffs.Num(i) >= 2) {
+		Growing[i] = SmoothedDiffs.Last(i) - SmoothedDiffs.Last(i, 1) >= 0;
+	}
+}
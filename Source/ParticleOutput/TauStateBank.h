@@ -0,0 +1,193 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Vector4.h"
+#include "TriangleHistory.h"
+#include "TauStateBank.generated.h"
+
+// How tau dot is estimated from the tau samples
+UENUM(BlueprintType)
+enum class ETauDerivativeEstimator : uint8
+{
+	// Difference of the last two samples, then a mean of three differences
+	Difference,
+	// Slope of a least squares polynomial fitted to the newest samples
+	SavitzkyGolay,
+	// Constant velocity Kalman filter per triangle
+	Kalman
+};
+
+USTRUCT(BlueprintType)
+struct FTauEstimatorSettings
+{
+	GENERATED_BODY()
+
+	// Samples the Savitzky-Golay polynomial is fitted to, at most the sample window
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauBuffer", meta = (ClampMin = "3"))
+	int32 SavitzkyGolayWindow = 7;
+
+	// Degree of the Savitzky-Golay polynomial. Higher follows sharp turns with less lag but more noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauBuffer", meta = (ClampMin = "1", ClampMax = "3"))
+	int32 SavitzkyGolayOrder = 2;
+
+	// Variance of the change in tau dot between samples the Kalman filter expects
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauBuffer", meta = (ClampMin = "0.0"))
+	float KalmanProcessNoise = 0.01f;
+
+	// Variance of the noise on each tau sample
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TauBuffer", meta = (ClampMin = "0.0"))
+	float KalmanMeasurementNoise = 1.0f;
+};
+
+// Estimate and covariance of one triangle's constant velocity Kalman filter
+struct FTauKalmanState
+{
+	double Tau = 0.0;
+	double TauDot = 0.0;
+	double P00 = 0.0;
+	double P01 = 0.0;
+	double P11 = 0.0;
+	bool bInitialized = false;
+};
+
+/*
+	Tau state of every tracked triangle of a performer. Each field is one array
+	indexed by triangle, so a whole performer is advanced by a single Update call
+	without any UObject or tick overhead.
+
+	A triangle's gesture starts at its Euler line when it begins tracking. Each
+	update measures the angle swept since the previous reading (incremental) and
+	since the start of the gesture (full), and derives tau, its rate of change and
+	a smoothed difference of that rate, which decides whether tau is growing.
+*/
+struct PARTICLEOUTPUT_API FTauStateBank
+{
+	// Circumcenter - A of each triangle when tracking began
+	TArray<FVector> MeasuringStick;
+
+	// Euler line at the start of the gesture and at the last reading. W is the reading time
+	TArray<FVector4> BeginningPosition;
+	TArray<FVector4> EndingPosition;
+
+	// The most recent readings of the Euler line, MotionPathWindow of them per triangle
+	TTriangleHistory<FVector4> MotionPath;
+
+	// Older readings, each the mean of CoarseMotionPathStride readings that left MotionPath
+	TTriangleHistory<FVector4> CoarseMotionPath;
+
+	// Window sizes, applied by Begin. A CoarseMotionPathStride of 0 drops old readings instead
+	int32 MotionPathWindow = 64;
+	int32 CoarseMotionPathWindow = 256;
+	int32 CoarseMotionPathStride = 16;
+
+	TArray<bool> IsGrowing;
+	TArray<bool> FullGestureIsGrowing;
+
+	TArray<double> BeginningTime;
+	TArray<double> LastReadingTime;
+	TArray<double> CurrentTime;
+	TArray<double> ElapsedSinceLastReadingTime;
+	TArray<double> ElapsedSinceBeginningGestureTime;
+
+	// Histories of the newest SampleWindow entries
+	TTriangleHistory<float> IncrementalGestureAngleChanges;
+	TTriangleHistory<float> FullGestureAngleChanges;
+	TTriangleHistory<double> IncrementalTauSamples;
+	TTriangleHistory<double> FullGestureTauSamples;
+	TTriangleHistory<float> IncrementalTauDotSamples;
+	TTriangleHistory<float> FullGestureTauDotSamples;
+	TTriangleHistory<float> IncrementalTauDotSmoothedDiffFromLastFrame;
+	TTriangleHistory<float> FullGestureTauDotSmoothedDiffFromLastFrame;
+
+	// Entries kept in each history, applied by Begin
+	int32 SampleWindow = 20;
+
+	// Tau dot estimator and its settings, applied by Begin. Tau dot is measured per sample
+	ETauDerivativeEstimator DerivativeEstimator = ETauDerivativeEstimator::Difference;
+	FTauEstimatorSettings EstimatorSettings;
+
+	// Latest tau estimate of each triangle, smoothed by the estimator, and how sure the estimator
+	// is of the sign of tau dot, from 0 to 1. The difference estimator always reports 1
+	TArray<double> IncrementalTauEstimate;
+	TArray<double> FullGestureTauEstimate;
+	TArray<float> IncrementalTauDotConfidence;
+	TArray<float> FullGestureTauDotConfidence;
+
+	int32 Num() const { return MeasuringStick.Num(); }
+
+	// Bytes held by the bank, which stay constant between calls to Begin
+	SIZE_T GetAllocatedSize() const;
+
+	// Removes every triangle
+	void Reset();
+
+	// Starts tracking NumTriangles triangles at Time. Each begins its gesture at its Euler line
+	void Begin(const TArray<FVector>& MeasuringSticks, const TArray<FVector>& EulerLines, double Time);
+
+	// Measures angles with the polynomial instead of atan2, within 4e-6 radians
+	bool bFastAngle = false;
+
+	// Takes a reading of the listed triangles at Time. The swept angles are measured four
+	// triangles per vector register, then each triangle's tau histories are advanced. Batches
+	// never span performers: UParticleGeneratorSubsystem runs each generator's bank on its own worker
+	void Update(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time);
+
+	// Update one triangle at a time with FVector math, the reference for Update
+	void UpdateScalar(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time);
+
+	// Runs both paths and returns the largest difference between the history entries they added,
+	// which is expected to be zero. Leaves the batched results in place and reports each path's time
+	double UpdateAndValidate(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time, double& OutSeconds, double& OutScalarSeconds);
+
+	// Angle in radians between two directions of any length, atan2(|A x B|, A . B). Unlike the
+	// arc cosine of the normalized dot product it keeps full precision near 0 and pi
+	static double GestureAngle(const FVector& A, const FVector& B);
+
+	// GestureAngle with atan2 replaced by an odd polynomial, see bFastAngle
+	static double FastGestureAngle(const FVector& A, const FVector& B);
+
+	// Logs the largest error of both angles and of the arc cosine against known angles
+	static void LogAngleAccuracy();
+
+private:
+	// The reading before the newest in the motion path
+	const FVector4& GetPreviousReading(int32 Triangle) const;
+
+	// Adds a reading to the motion path, folding the one it evicts into the coarse tier
+	void AddToMotionPath(int32 Triangle, const FVector4& Reading);
+
+	// Sum and count of the evicted readings not yet folded into a coarse reading
+	TArray<FVector4> CoarseSums;
+	TArray<int32> CoarseCounts;
+
+	// Records the reading of each listed triangle and fills Readings with the valid ones
+	void AddReadings(const TArray<int32>& Triangles, const TArray<FVector>& EulerLines, double Time);
+
+	// Estimates tau dot from the newest tau samples with the selected estimator and adds it to
+	// the histories. IsGrowing follows the change in tau dot without further smoothing
+	void EstimateTauDot(int32 Triangle, const TTriangleHistory<double>& TauSamples, TArray<FTauKalmanState>& Kalman,
+		TArray<double>& TauEstimates, TArray<float>& Confidences, TTriangleHistory<float>& TauDotSamples,
+		TTriangleHistory<float>& SmoothedDiffs, TArray<bool>& Growing);
+
+	// Savitzky-Golay weights for each number of samples N a fit can use. SavitzkyGolayOffsets[N] is
+	// where N's Order + 1 rows of N weights start, row k giving the coefficient of t^k with the
+	// newest sample at t = 0
+	TArray<double> SavitzkyGolayWeights;
+	TArray<int32> SavitzkyGolayOffsets;
+
+	TArray<FTauKalmanState> IncrementalKalman;
+	TArray<FTauKalmanState> FullGestureKalman;
+
+	// Advance the histories of one triangle with the angle swept this reading
+	void UpdateIncrementalGestureChange(int32 Triangle, float AngleChange);
+	void UpdateFullGestureChange(int32 Triangle, float AngleChange);
+
+	// Scratch for the batched update, kept to avoid allocating each reading
+	TArray<int32> Readings;
+	TArray<double> PreviousX, PreviousY, PreviousZ;
+	TArray<double> EndingX, EndingY, EndingZ;
+	TArray<double> BeginningX, BeginningY, BeginningZ;
+	TArray<double> IncrementalAngles, FullGestureAngles;
+};
@@ -0,0 +1,308 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "DynamicTexture.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#define DYNAMIC_TEXTURE_TEST_SIZE 8
+
+// Rows a draw list rasterizes per band, matches DRAW_LIST_BAND_HEIGHT
+#define DYNAMIC_TEXTURE_TEST_BAND_HEIGHT 32
+
+// Clears the canvas, draws into it and publishes the result, so the snapshot holds exactly what Draw wrote
+static FDynamicTextureSnapshot DrawFrame(UDynamicTexture* Texture, TFunctionRef<void(UDynamicTexture*)> Draw)
+{
+	Texture->Clear();
+	Draw(Texture);
+	Texture->UpdateTexture();
+	return Texture->GetSnapshot();
+}
+
+// Checks every pixel of a BGRA8 frame is white where Expected says so and the clear color elsewhere
+static void TestPixels(FAutomationTestBase& Test, const TCHAR* What, const FDynamicTextureSnapshot& Frame, TFunctionRef<bool(int32, int32)> Expected)
+{
+	if (!Test.TestTrue(FString::Printf(TEXT("%s: a frame was published"), What), Frame.IsValid())) {
+		return;
+	}
+	const FColor* Pixels = reinterpret_cast<const FColor*>(Frame->Pixels.GetData());
+	int32 Wrong = 0;
+	for (int32 Y = 0; Y < Frame->Height; Y++)
+	{
+		for (int32 X = 0; X < Frame->Width; X++)
+		{
+			const FColor ExpectedColor = Expected(X, Y) ? FColor::White : FColor::Black;
+			if (Pixels[X + Y * Frame->Width] != ExpectedColor) {
+				Wrong++;
+			}
+		}
+	}
+	Test.TestEqual(FString::Printf(TEXT("%s: wrong pixels"), What), Wrong, 0);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDynamicTextureFillRectClipTest, "ParticleOutput.DynamicTexture.FillRectClipsToCanvas", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FDynamicTextureFillRectClipTest::RunTest(const FString& Parameters)
+{
+	UDynamicTexture* Texture = NewObject<UDynamicTexture>();
+	Texture->Initialize(DYNAMIC_TEXTURE_TEST_SIZE, DYNAMIC_TEXTURE_TEST_SIZE, FLinearColor::Black);
+
+	TestPixels(*this, TEXT("Over the top left corner"),
+		DrawFrame(Texture, [](UDynamicTexture* T) { T->FillRect(-2, -2, 4, 4, FLinearColor::White); }),
+		[](int32 X, int32 Y) { return X < 2 && Y < 2; });
+
+	TestPixels(*this, TEXT("Over the bottom right corner"),
+		DrawFrame(Texture, [](UDynamicTexture* T) { T->FillRect(6, 6, 10, 10, FLinearColor::White); }),
+		[](int32 X, int32 Y) { return X >= 6 && Y >= 6; });
+
+	TestPixels(*this, TEXT("Larger than the canvas"),
+		DrawFrame(Texture, [](UDynamicTexture* T) { T->FillRect(-100, -100, 200, 200, FLinearColor::White); }),
+		[](int32 X, int32 Y) { return true; });
+
+	TestPixels(*this, TEXT("Touching the edges from outside"),
+		DrawFrame(Texture, [](UDynamicTexture* T)
+		{
+			T->FillRect(-4, 0, 4, 4, FLinearColor::White);
+			T->FillRect(DYNAMIC_TEXTURE_TEST_SIZE, 0, 4, 4, FLinearColor::White);
+			T->FillRect(0, -4, 4, 4, FLinearColor::White);
+			T->FillRect(0, DYNAMIC_TEXTURE_TEST_SIZE, 4, 4, FLinearColor::White);
+		}),
+		[](int32 X, int32 Y) { return false; });
+
+	TestPixels(*this, TEXT("Empty rectangles"),
+		DrawFrame(Texture, [](UDynamicTexture* T)
+		{
+			T->FillRect(2, 2, 0, 4, FLinearColor::White);
+			T->FillRect(2, 2, -3, 4, FLinearColor::White);
+		}),
+		[](int32 X, int32 Y) { return false; });
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDynamicTextureDrawLineClipTest, "ParticleOutput.DynamicTexture.DrawLineClipsToCanvas", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FDynamicTextureDrawLineClipTest::RunTest(const FString& Parameters)
+{
+	UDynamicTexture* Texture = NewObject<UDynamicTexture>();
+	Texture->Initialize(DYNAMIC_TEXTURE_TEST_SIZE, DYNAMIC_TEXTURE_TEST_SIZE, FLinearColor::Black);
+
+	TestPixels(*this, TEXT("Across the whole canvas"),
+		DrawFrame(Texture, [](UDynamicTexture* T) { T->DrawLine(-5, 3, 20, 3, FLinearColor::White); }),
+		[](int32 X, int32 Y) { return Y == 3; });
+
+	TestPixels(*this, TEXT("Down past the bottom edge"),
+		DrawFrame(Texture, [](UDynamicTexture* T) { T->DrawLine(5, 4, 5, 40, FLinearColor::White); }),
+		[](int32 X, int32 Y) { return X == 5 && Y >= 4; });
+
+	TestPixels(*this, TEXT("Diagonal through two corners"),
+		DrawFrame(Texture, [](UDynamicTexture* T) { T->DrawLine(-3, -3, 10, 10, FLinearColor::White); }),
+		[](int32 X, int32 Y) { return X == Y; });
+
+	TestPixels(*this, TEXT("Entirely outside"),
+		DrawFrame(Texture, [](UDynamicTexture* T)
+		{
+			T->DrawLine(-5, -5, -1, 10, FLinearColor::White);
+			T->DrawLine(0, DYNAMIC_TEXTURE_TEST_SIZE, 20, DYNAMIC_TEXTURE_TEST_SIZE + 4, FLinearColor::White);
+		}),
+		[](int32 X, int32 Y) { return false; });
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDynamicTexturePixelFormatsTest, "ParticleOutput.DynamicTexture.PixelFormatsPackAndBlend", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FDynamicTexturePixelFormatsTest::RunTest(const FString& Parameters)
+{
+	// R8 keeps the red channel, clamped and truncated like the other 8 bit formats
+	TestEqual(TEXT("R8 packs white"), int32(FDynamicTexturePixelR8::Pack(FLinearColor::White)), 255);
+	TestEqual(TEXT("R8 packs black"), int32(FDynamicTexturePixelR8::Pack(FLinearColor::Black)), 0);
+	TestEqual(TEXT("R8 packs half red"), int32(FDynamicTexturePixelR8::Pack(FLinearColor(0.5f, 1.0f, 1.0f))), 127);
+	TestEqual(TEXT("R8 clamps above one"), int32(FDynamicTexturePixelR8::Pack(FLinearColor(2.0f, 0.0f, 0.0f))), 255);
+	TestEqual(TEXT("R8 clamps below zero"), int32(FDynamicTexturePixelR8::Pack(FLinearColor(-1.0f, 0.0f, 0.0f))), 0);
+	TestEqual(TEXT("R8 from color"), int32(FDynamicTexturePixelR8::FromColor(FColor(200, 10, 20))), 200);
+	TestEqual(TEXT("R8 blend with no alpha"), int32(FDynamicTexturePixelR8::Blend(10, 200, 0)), 10);
+	TestEqual(TEXT("R8 blend with full alpha"), int32(FDynamicTexturePixelR8::Blend(10, 200, 256)), 200);
+	TestEqual(TEXT("R8 blend halfway"), int32(FDynamicTexturePixelR8::Blend(0, 255, 128)), 127);
+
+	// RGB8 drops alpha and keeps the channels in red green blue order
+	auto TestRGB8 = [this](const TCHAR* What, const FDynamicTextureRGB8& Actual, uint8 R, uint8 G, uint8 B)
+	{
+		TestTrue(What, Actual.R == R && Actual.G == G && Actual.B == B);
+	};
+	const FDynamicTextureRGB8 Dst = { 10, 20, 30 };
+	const FDynamicTextureRGB8 Src = { 200, 100, 50 };
+	TestRGB8(TEXT("RGB8 packs white"), FDynamicTexturePixelRGB8::Pack(FLinearColor::White), 255, 255, 255);
+	TestRGB8(TEXT("RGB8 packs in channel order"), FDynamicTexturePixelRGB8::Pack(FLinearColor(1.0f, 0.5f, 0.0f, 0.0f)), 255, 127, 0);
+	TestRGB8(TEXT("RGB8 clamps"), FDynamicTexturePixelRGB8::Pack(FLinearColor(3.0f, -2.0f, 1.0f)), 255, 0, 255);
+	TestRGB8(TEXT("RGB8 from color"), FDynamicTexturePixelRGB8::FromColor(FColor(1, 2, 3, 4)), 1, 2, 3);
+	TestRGB8(TEXT("RGB8 blend with no alpha"), FDynamicTexturePixelRGB8::Blend(Dst, Src, 0), 10, 20, 30);
+	TestRGB8(TEXT("RGB8 blend with full alpha"), FDynamicTexturePixelRGB8::Blend(Dst, Src, 256), 200, 100, 50);
+	TestRGB8(TEXT("RGB8 blend halfway"), FDynamicTexturePixelRGB8::Blend(Dst, Src, 128), 105, 60, 40);
+
+	// RGBA16F keeps HDR values, and every value here is exact in half precision
+	const FLinearColor HDR(4.0f, 0.5f, -1.0f, 1.0f);
+	TestEqual(TEXT("RGBA16F packs unclamped"), FDynamicTexturePixelRGBA16F::Pack(HDR).GetFloats(), HDR);
+	TestEqual(TEXT("RGBA16F from color"), FDynamicTexturePixelRGBA16F::FromColor(FColor::White).GetFloats(), FLinearColor::White);
+	const FFloat16Color HalfDst(FLinearColor(0.0f, 0.0f, 0.0f, 0.0f));
+	const FFloat16Color HalfSrc(FLinearColor(2.0f, 1.0f, 0.5f, 1.0f));
+	TestEqual(TEXT("RGBA16F blend with no alpha"), FDynamicTexturePixelRGBA16F::Blend(HalfDst, HalfSrc, 0).GetFloats(), FLinearColor(0.0f, 0.0f, 0.0f, 0.0f));
+	TestEqual(TEXT("RGBA16F blend with full alpha"), FDynamicTexturePixelRGBA16F::Blend(HalfDst, HalfSrc, 256).GetFloats(), FLinearColor(2.0f, 1.0f, 0.5f, 1.0f));
+	TestEqual(TEXT("RGBA16F blend halfway"), FDynamicTexturePixelRGBA16F::Blend(HalfDst, HalfSrc, 128).GetFloats(), FLinearColor(1.0f, 0.5f, 0.25f, 0.5f));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDynamicTextureRGB8UploadTest, "ParticleOutput.DynamicTexture.RGB8ExpandsForUpload", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FDynamicTextureRGB8UploadTest::RunTest(const FString& Parameters)
+{
+	UDynamicTexture* Texture = NewObject<UDynamicTexture>();
+	Texture->Initialize(DYNAMIC_TEXTURE_TEST_SIZE, DYNAMIC_TEXTURE_TEST_SIZE, FLinearColor::Black, TextureFilter::TF_Nearest, EDynamicTexturePixelFormat::RGB8);
+
+	const FIntRect Filled(2, 3, 5, 5);
+	const FDynamicTextureSnapshot Frame = DrawFrame(Texture, [&Filled](UDynamicTexture* T)
+	{
+		T->FillRect(Filled.Min.X, Filled.Min.Y, Filled.Width(), Filled.Height(), FLinearColor(1.0f, 0.5f, 0.0f));
+	});
+	if (!TestTrue(TEXT("A frame was published"), Frame.IsValid())) {
+		return false;
+	}
+
+	// Snapshots keep the 3 byte storage layout, only the upload is expanded
+	TestTrue(TEXT("Snapshot format"), Frame->Format == EDynamicTexturePixelFormat::RGB8);
+	TestEqual(TEXT("Snapshot bytes per pixel"), Frame->BytesPerPixel, 3);
+	TestEqual(TEXT("Snapshot size"), Frame->Pixels.Num(), DYNAMIC_TEXTURE_TEST_SIZE * DYNAMIC_TEXTURE_TEST_SIZE * 3);
+	const FDynamicTextureRGB8* Stored = reinterpret_cast<const FDynamicTextureRGB8*>(Frame->Pixels.GetData());
+	const FDynamicTextureRGB8& Inside = Stored[Filled.Min.X + Filled.Min.Y * DYNAMIC_TEXTURE_TEST_SIZE];
+	TestTrue(TEXT("Stored in red green blue order"), Inside.R == 255 && Inside.G == 127 && Inside.B == 0);
+
+	// Expand a dirty region reaching one pixel past the fill on every side, as UpdateTexture does.
+	// Rows are tightly packed BGRA, and nothing is written past the end of the region
+	const FIntRect Dirty(Filled.Min - FIntPoint(1, 1), Filled.Max + FIntPoint(1, 1));
+	const int32 NumRegionPixels = Dirty.Width() * Dirty.Height();
+	TArray<FColor> Staging;
+	Staging.Init(FColor(1, 2, 3, 4), NumRegionPixels + 1);
+	ConvertDynamicTextureRegionForUpload<FDynamicTexturePixelRGB8>(Frame->Pixels.GetData(), Frame->Width, Dirty, reinterpret_cast<uint8*>(Staging.GetData()));
+
+	int32 Wrong = 0;
+	for (int32 Y = Dirty.Min.Y; Y < Dirty.Max.Y; Y++)
+	{
+		for (int32 X = Dirty.Min.X; X < Dirty.Max.X; X++)
+		{
+			const FColor Expected = Filled.Contains(FIntPoint(X, Y)) ? FColor(255, 127, 0, 255) : FColor(0, 0, 0, 255);
+			if (Staging[(X - Dirty.Min.X) + (Y - Dirty.Min.Y) * Dirty.Width()] != Expected) {
+				Wrong++;
+			}
+		}
+	}
+	TestEqual(TEXT("Wrong expanded pixels"), Wrong, 0);
+	TestTrue(TEXT("Staging past the region untouched"), Staging[NumRegionPixels] == FColor(1, 2, 3, 4));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDynamicTextureDrawListBandsTest, "ParticleOutput.DynamicTexture.DrawListBandsMatchSingleBand", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FDynamicTextureDrawListBandsTest::RunTest(const FString& Parameters)
+{
+	// A canvas five bands tall, with enough commands for the bands to be rasterized in parallel
+	const int32 Width = 48;
+	const int32 Height = DYNAMIC_TEXTURE_TEST_BAND_HEIGHT * 5;
+	const int32 NumCommands = 96;
+
+	FColor SpritePixels[6 * 5];
+	for (int32 i = 0; i < 6 * 5; i++)
+	{
+		SpritePixels[i] = FColor(40 * (i % 6), 50 * (i / 6), 200, i % 3 == 0 ? 255 : 35 * (i % 7));
+	}
+
+	// Records the same random commands every time, moved up by OffsetY rows. Coordinates are
+	// multiples of a quarter and smooth lines run a power of two along their major axis, so the
+	// rasterizers' arithmetic is exact and moving a command by whole rows moves its pixels as far
+	auto Record = [&](FDynamicTextureDrawList& List, int32 OffsetY)
+	{
+		List.Empty();
+		const int32 Sprite = List.RegisterSprite(SpritePixels, 6, 5);
+		FRandomStream Random(4321);
+		auto Coordinate = [&Random](int32 Min, int32 Max) { return Random.RandRange(Min * 4, Max * 4) * 0.25f; };
+		const float Alphas[] = { 1.0f, 0.5f, 0.25f };
+
+		for (int32 i = 0; i < NumCommands; i++)
+		{
+			const FLinearColor Color(Random.FRand(), Random.FRand(), Random.FRand(), Alphas[Random.RandRange(0, 2)]);
+			switch (i % 6)
+			{
+			case 0:
+				List.AddLine(
+					Random.RandRange(-8, Width + 8), Random.RandRange(-8, Height + 8) - OffsetY,
+					Random.RandRange(-8, Width + 8), Random.RandRange(-8, Height + 8) - OffsetY, Color);
+				break;
+			case 1:
+			{
+				const float X = Coordinate(-8, Width + 8);
+				const float Y = Coordinate(-8, Height + 8) - OffsetY;
+				const int32 Length = 1 << Random.RandRange(2, 6);
+				const float Major = Random.RandRange(0, 1) ? Length : -Length;
+				const float Minor = Random.RandRange(-Length * 4 + 1, Length * 4 - 1) * 0.25f;
+				if (Random.RandRange(0, 1)) {
+					List.AddSmoothLine(X, Y, X + Minor, Y + Major, Color);
+				}
+				else {
+					List.AddSmoothLine(X, Y, X + Major, Y + Minor, Color);
+				}
+				break;
+			}
+			case 2:
+			case 3:
+				List.AddCircle(Coordinate(-8, Width + 8), Coordinate(-8, Height + 8) - OffsetY, Coordinate(0, 24), Color, i % 6 == 3);
+				break;
+			case 4:
+				List.AddTriangle(
+					FVector2f(Coordinate(-8, Width + 8), Coordinate(-8, Height + 8) - OffsetY),
+					FVector2f(Coordinate(-8, Width + 8), Coordinate(-8, Height + 8) - OffsetY),
+					FVector2f(Coordinate(-8, Width + 8), Coordinate(-8, Height + 8) - OffsetY), Color);
+				break;
+			case 5:
+				List.AddSprite(Sprite, Random.RandRange(-4, Width), Random.RandRange(-4, Height) - OffsetY, Color);
+				break;
+			}
+		}
+	};
+
+	const EDynamicTexturePixelFormat Formats[] = { EDynamicTexturePixelFormat::BGRA8, EDynamicTexturePixelFormat::R8, EDynamicTexturePixelFormat::RGB8, EDynamicTexturePixelFormat::RGBA16F };
+	for (EDynamicTexturePixelFormat Format : Formats)
+	{
+		const SIZE_T RowBytes = SIZE_T(Width) * GetDynamicTextureBytesPerPixel(Format);
+		FDynamicTextureDrawList List;
+		Record(List, 0);
+		TArray<uint8> Canvas;
+		Canvas.SetNumZeroed(RowBytes * Height);
+		List.Execute(Canvas.GetData(), Width, Height, Format);
+		TestTrue(FString::Printf(TEXT("Format %i: something was drawn"), int32(Format)), Canvas.ContainsByPredicate([](uint8 Byte) { return Byte != 0; }));
+
+		// Each window one band tall is drawn again on a canvas of its own, where it is a single band.
+		// Every other window straddles two bands of the tall canvas
+		int32 WrongRows = 0;
+		TArray<uint8> Window;
+		for (int32 OffsetY = 0; OffsetY + DYNAMIC_TEXTURE_TEST_BAND_HEIGHT <= Height; OffsetY += DYNAMIC_TEXTURE_TEST_BAND_HEIGHT / 2)
+		{
+			Record(List, OffsetY);
+			Window.Reset();
+			Window.SetNumZeroed(RowBytes * DYNAMIC_TEXTURE_TEST_BAND_HEIGHT);
+			List.Execute(Window.GetData(), Width, DYNAMIC_TEXTURE_TEST_BAND_HEIGHT, Format);
+			for (int32 Row = 0; Row < DYNAMIC_TEXTURE_TEST_BAND_HEIGHT; Row++)
+			{
+				if (FMemory::Memcmp(Canvas.GetData() + (OffsetY + Row) * RowBytes, Window.GetData() + Row * RowBytes, RowBytes) != 0) {
+					WrongRows++;
+				}
+			}
+		}
+		TestEqual(FString::Printf(TEXT("Format %i: rows differing from a single band"), int32(Format)), WrongRows, 0);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "RobustPredicates.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Offsets from 0.5 tried on each axis, in units of its ulp. Below half an ulp of 23.5 they vanish in the filter
+#define ROBUST_PREDICATES_TEST_STEPS 16
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRobustPredicatesNearCollinearTest, "ParticleOutput.RobustPredicates.NearCollinear", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRobustPredicatesNearCollinearTest::RunTest(const FString& Parameters)
+{
+	// Shewchuk's example: a moves by single ulps around (0.5, 0.5), next to the line through b and c.
+	// The determinant is 12 * (ay - ax), but in plain floating point both products round to 282 and
+	// cancel, so only the exact path gets the sign
+	const double Ulp = 1.1102230246251565e-16;
+	const double b[2] = { 12.0, 12.0 };
+	const double c[2] = { 24.0, 24.0 };
+
+	FRobustPredicates::ResetStats();
+	int32 WrongSigns = 0;
+	int32 NaiveWrongSigns = 0;
+	for (int32 i = 0; i < ROBUST_PREDICATES_TEST_STEPS; i++)
+	{
+		for (int32 j = 0; j < ROBUST_PREDICATES_TEST_STEPS; j++)
+		{
+			const double a[2] = { 0.5 + i * Ulp, 0.5 + j * Ulp };
+			const double Expected = FMath::Sign(double(j - i));
+			const double Naive = (a[0] - c[0]) * (b[1] - c[1]) - (a[1] - c[1]) * (b[0] - c[0]);
+			WrongSigns += FMath::Sign(FRobustPredicates::Orient2D(a, b, c)) != Expected ? 1 : 0;
+			NaiveWrongSigns += FMath::Sign(Naive) != Expected ? 1 : 0;
+		}
+	}
+
+	const uint64 NumCalls = ROBUST_PREDICATES_TEST_STEPS * ROBUST_PREDICATES_TEST_STEPS;
+	const FRobustPredicates::FStats Stats = FRobustPredicates::GetStats();
+	AddInfo(FString::Printf(TEXT("Plain floating point got %i of %llu signs wrong"), NaiveWrongSigns, NumCalls));
+	TestTrue(TEXT("The inputs defeat plain floating point"), NaiveWrongSigns > 0);
+	TestEqual(TEXT("Wrong signs"), WrongSigns, 0);
+	TestEqual(TEXT("Calls counted"), Stats.Orient2DCalls, NumCalls);
+	TestEqual(TEXT("Every call took the exact path"), Stats.Orient2DExact, NumCalls);
+
+	// A well separated triangle is decided by the filter alone
+	const double p[2] = { 0.0, 0.0 };
+	const double q[2] = { 1.0, 0.0 };
+	const double r[2] = { 0.0, 1.0 };
+	TestEqual(TEXT("Counterclockwise triangle"), FRobustPredicates::Orient2D(p, q, r), 1.0);
+	TestEqual(TEXT("Clockwise triangle"), FRobustPredicates::Orient2D(p, r, q), -1.0);
+	const FRobustPredicates::FStats After = FRobustPredicates::GetStats();
+	TestEqual(TEXT("Filtered calls counted"), After.Orient2DCalls, NumCalls + 2);
+	TestEqual(TEXT("Filtered calls stay off the exact path"), After.Orient2DExact, NumCalls);
+
+	// Filtered evaluations a caller records count as calls only
+	FRobustPredicates::RecordFilteredOrient2D(5);
+	TestEqual(TEXT("Recorded calls"), FRobustPredicates::GetStats().Orient2DCalls, NumCalls + 7);
+
+	FRobustPredicates::ResetStats();
+	TestEqual(TEXT("Reset calls"), FRobustPredicates::GetStats().Orient2DCalls, uint64(0));
+	TestEqual(TEXT("Reset exact calls"), FRobustPredicates::GetStats().Orient2DExact, uint64(0));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,263 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "TauStateBank.h"
+#include "Async/ParallelFor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Euler lines of NumTriangles triangles, each turning at its own rate and wobbling out of plane
+struct FTauTestMotion
+{
+	TArray<FVector> MeasuringSticks;
+	TArray<FVector> EulerLines;
+
+	explicit FTauTestMotion(int32 NumTriangles)
+	{
+		for (int32 i = 0; i < NumTriangles; i++)
+		{
+			MeasuringSticks.Add(FVector(10.0 + i % 7, 0.0, 0.0));
+		}
+		EulerLines.SetNum(NumTriangles);
+		Advance(0);
+	}
+
+	void Advance(int32 Frame)
+	{
+		for (int32 i = 0; i < EulerLines.Num(); i++)
+		{
+			const double Angle = Frame * 0.004 * (1 + i % 9);
+			EulerLines[i] = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.2 * FMath::Sin(Frame * 0.01 + i)) * (1.0 + i % 3);
+		}
+	}
+};
+
+// Runs NumFrames readings of the listed triangles through both update paths, returning the largest difference
+static double RunValidatedFrames(FTauStateBank& Bank, FTauTestMotion& Motion, const TArray<int32>& Triangles, int32 NumFrames, double& OutSeconds, double& OutScalarSeconds)
+{
+	Bank.Begin(Motion.MeasuringSticks, Motion.EulerLines, 0.0);
+	double MaxDeviation = 0.0;
+	OutSeconds = 0.0;
+	OutScalarSeconds = 0.0;
+	for (int32 Frame = 1; Frame <= NumFrames; Frame++)
+	{
+		Motion.Advance(Frame);
+		double Seconds = 0.0, ScalarSeconds = 0.0;
+		MaxDeviation = FMath::Max(MaxDeviation, Bank.UpdateAndValidate(Triangles, Motion.EulerLines, Frame / 60.0, Seconds, ScalarSeconds));
+		OutSeconds += Seconds;
+		OutScalarSeconds += ScalarSeconds;
+	}
+	return MaxDeviation;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauStateBankBatchedMatchesScalarTest, "ParticleOutput.TauStateBank.BatchedMatchesScalar", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTauStateBankBatchedMatchesScalarTest::RunTest(const FString& Parameters)
+{
+	// Not a multiple of four, so the kernel's leftover triangles are covered too
+	const int32 NumTriangles = 67;
+	TArray<int32> AllTriangles;
+	TArray<int32> SomeTriangles;
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		AllTriangles.Add(i);
+		if (i % 3 != 1) {
+			SomeTriangles.Add(i);
+		}
+	}
+
+	for (const bool bFastAngle : { false, true })
+	{
+		const TCHAR* AngleName = bFastAngle ? TEXT("polynomial angle") : TEXT("atan2 angle");
+		double Seconds = 0.0, ScalarSeconds = 0.0;
+
+		FTauStateBank Bank;
+		Bank.bFastAngle = bFastAngle;
+		FTauTestMotion Motion(NumTriangles);
+		TestEqual(FString::Printf(TEXT("Every triangle, %s"), AngleName), RunValidatedFrames(Bank, Motion, AllTriangles, 200, Seconds, ScalarSeconds), 0.0);
+
+		// Triangles skipped by the adaptive tracking stay out of the readings
+		FTauStateBank Partial;
+		Partial.bFastAngle = bFastAngle;
+		FTauTestMotion PartialMotion(NumTriangles);
+		TestEqual(FString::Printf(TEXT("Some triangles, %s"), AngleName), RunValidatedFrames(Partial, PartialMotion, SomeTriangles, 200, Seconds, ScalarSeconds), 0.0);
+		TestEqual(FString::Printf(TEXT("Skipped triangle has no readings, %s"), AngleName), Partial.IncrementalTauSamples.Num(1), 0);
+	}
+
+	// Each estimator advances its own state, which the scalar path has to match as well
+	for (const ETauDerivativeEstimator Estimator : { ETauDerivativeEstimator::SavitzkyGolay, ETauDerivativeEstimator::Kalman })
+	{
+		FTauStateBank Bank;
+		Bank.DerivativeEstimator = Estimator;
+		FTauTestMotion Motion(NumTriangles);
+		double Seconds = 0.0, ScalarSeconds = 0.0;
+		TestEqual(FString::Printf(TEXT("Estimator %s"), *UEnum::GetValueAsString(Estimator)), RunValidatedFrames(Bank, Motion, AllTriangles, 200, Seconds, ScalarSeconds), 0.0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauStateBankUpdateBenchmark, "ParticleOutput.TauStateBank.UpdateBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FTauStateBankUpdateBenchmark::RunTest(const FString& Parameters)
+{
+	// Each path updates its own bank, as validating copies the whole bank every reading. Times
+	// are reported, not checked, as they depend on the machine
+	const int32 NumFrames = 300;
+	for (const int32 NumTriangles : { 67, 1024, 8192 })
+	{
+		TArray<int32> Triangles;
+		for (int32 i = 0; i < NumTriangles; i++)
+		{
+			Triangles.Add(i);
+		}
+
+		for (const bool bFastAngle : { false, true })
+		{
+			FTauTestMotion Motion(NumTriangles);
+			FTauStateBank Batched;
+			FTauStateBank Scalar;
+			Batched.bFastAngle = bFastAngle;
+			Scalar.bFastAngle = bFastAngle;
+			Batched.Begin(Motion.MeasuringSticks, Motion.EulerLines, 0.0);
+			Scalar.Begin(Motion.MeasuringSticks, Motion.EulerLines, 0.0);
+
+			double Seconds = 0.0, ScalarSeconds = 0.0;
+			for (int32 Frame = 1; Frame <= NumFrames; Frame++)
+			{
+				Motion.Advance(Frame);
+
+				double StartTime = FPlatformTime::Seconds();
+				Batched.Update(Triangles, Motion.EulerLines, Frame / 60.0);
+				Seconds += FPlatformTime::Seconds() - StartTime;
+
+				StartTime = FPlatformTime::Seconds();
+				Scalar.UpdateScalar(Triangles, Motion.EulerLines, Frame / 60.0);
+				ScalarSeconds += FPlatformTime::Seconds() - StartTime;
+			}
+			TestEqual(FString::Printf(TEXT("%i triangles end on the same tau"), NumTriangles), Batched.FullGestureTauSamples.ToArray(NumTriangles - 1), Scalar.FullGestureTauSamples.ToArray(NumTriangles - 1));
+
+			AddInfo(FString::Printf(TEXT("%i triangles, %s: batched %.3f ms, scalar %.3f ms per reading, %.2fx"),
+				NumTriangles, bFastAngle ? TEXT("polynomial angle") : TEXT("atan2 angle"),
+				Seconds * 1000.0 / NumFrames, ScalarSeconds * 1000.0 / NumFrames, Seconds > 0.0 ? ScalarSeconds / Seconds : 0.0));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauStateBankPerformerBenchmark, "ParticleOutput.TauStateBank.PerformerBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FTauStateBankPerformerBenchmark::RunTest(const FString& Parameters)
+{
+	// A frame of the subsystem's tracking stage for up to 50 performers of the default topology, at
+	// 60 frames a second and the default 120 readings a second. Banks advance one after another, as
+	// they used to, and in parallel, as UParticleGeneratorSubsystem runs them
+	const int32 NumTriangles = 67;
+	const int32 NumFrames = 120;
+	const int32 ReadingsPerFrame = 2;
+	const double FrameBudget = 1000.0 / 60.0;
+
+	TArray<int32> Triangles;
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		Triangles.Add(i);
+	}
+
+	for (const int32 NumPerformers : { 1, 10, 25, 50 })
+	{
+		TArray<FTauTestMotion> Motions;
+		TArray<FTauStateBank> Serial;
+		TArray<FTauStateBank> Parallel;
+		for (int32 i = 0; i < NumPerformers; i++)
+		{
+			Motions.Emplace(NumTriangles);
+			Serial.AddDefaulted_GetRef().Begin(Motions[i].MeasuringSticks, Motions[i].EulerLines, 0.0);
+			Parallel.AddDefaulted_GetRef().Begin(Motions[i].MeasuringSticks, Motions[i].EulerLines, 0.0);
+		}
+
+		double SerialSeconds = 0.0, ParallelSeconds = 0.0;
+		for (int32 Frame = 1; Frame <= NumFrames; Frame++)
+		{
+			for (FTauTestMotion& Motion : Motions)
+			{
+				Motion.Advance(Frame);
+			}
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < NumPerformers; i++)
+			{
+				for (int32 Reading = 0; Reading < ReadingsPerFrame; Reading++)
+				{
+					Serial[i].Update(Triangles, Motions[i].EulerLines, (Frame * ReadingsPerFrame + Reading) / 120.0);
+				}
+			}
+			SerialSeconds += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			ParallelFor(NumPerformers, [&Parallel, &Motions, &Triangles, Frame, ReadingsPerFrame](int32 i)
+			{
+				for (int32 Reading = 0; Reading < ReadingsPerFrame; Reading++)
+				{
+					Parallel[i].Update(Triangles, Motions[i].EulerLines, (Frame * ReadingsPerFrame + Reading) / 120.0);
+				}
+			});
+			ParallelSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+		TestEqual(FString::Printf(TEXT("%i performers end on the same tau"), NumPerformers),
+			Parallel.Last().FullGestureTauSamples.ToArray(NumTriangles - 1), Serial.Last().FullGestureTauSamples.ToArray(NumTriangles - 1));
+
+		const double SerialMs = SerialSeconds * 1000.0 / NumFrames;
+		const double ParallelMs = ParallelSeconds * 1000.0 / NumFrames;
+		AddInfo(FString::Printf(TEXT("%i performers: serial %.3f ms, parallel %.3f ms per frame, %.1f%% of a 60 Hz frame"),
+			NumPerformers, SerialMs, ParallelMs, ParallelMs * 100.0 / FrameBudget));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauStateBankGestureAngleTest, "ParticleOutput.TauStateBank.GestureAngleNearParallel", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTauStateBankGestureAngleTest::RunTest(const FString& Parameters)
+{
+	// Pairs a known angle apart near 0 and near pi, where gestures start and stop, turned to a
+	// random orientation and given lengths far from one
+	FRandomStream Random(0x7A0);
+	double MaxRelativeError = 0.0;
+	double MaxFastError = 0.0;
+	double MaxRelativeAcosError = 0.0;
+	for (const double Offset : { 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2 })
+	{
+		for (const bool bAntiParallel : { false, true })
+		{
+			const double Angle = bAntiParallel ? UE_DOUBLE_PI - Offset : Offset;
+			const FQuat Orientation = FRotator(Random.FRandRange(-180.0, 180.0), Random.FRandRange(-180.0, 180.0), Random.FRandRange(-180.0, 180.0)).Quaternion();
+			const FVector A = Orientation.RotateVector(FVector(3.0, 0.0, 0.0));
+			const FVector B = Orientation.RotateVector(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * 250.0);
+
+			MaxRelativeError = FMath::Max(MaxRelativeError, FMath::Abs(FTauStateBank::GestureAngle(A, B) - Angle) / Offset);
+			MaxFastError = FMath::Max(MaxFastError, FMath::Abs(FTauStateBank::FastGestureAngle(A, B) - Angle));
+
+			// The arc cosine of the normalized dot product the angle used to be measured with
+			const double AcosAngle = FMath::Acos(FMath::Clamp(FVector::DotProduct(A.GetSafeNormal(), B.GetSafeNormal()), -1.0, 1.0));
+			if (Offset < 1e-6) {
+				MaxRelativeAcosError = FMath::Max(MaxRelativeAcosError, FMath::Abs(AcosAngle - Angle) / Offset);
+			}
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("Relative error from the nearest end, atan2: %g, acos at 1e-7: %g. Polynomial error: %g"), MaxRelativeError, MaxRelativeAcosError, MaxFastError));
+	TestTrue(TEXT("atan2 keeps its precision near 0 and pi"), MaxRelativeError < 1e-6);
+	TestTrue(TEXT("acos loses it"), MaxRelativeAcosError > 1e-5);
+	TestTrue(TEXT("Polynomial angle within 4e-6 radians"), MaxFastError < 4e-6);
+
+	// Parallel, opposite and square directions land exactly, however long they are
+	TestEqual(TEXT("Parallel"), FTauStateBank::GestureAngle(FVector(2, 0, 0), FVector(500, 0, 0)), 0.0);
+	TestEqual(TEXT("Opposite"), FTauStateBank::GestureAngle(FVector(0, 0, 2), FVector(0, 0, -500)), UE_DOUBLE_PI);
+	TestEqual(TEXT("Square"), FTauStateBank::GestureAngle(FVector(0, 7, 0), FVector(0, 0, 0.01)), UE_DOUBLE_HALF_PI);
+
+	return true;
+}
+
+#endif
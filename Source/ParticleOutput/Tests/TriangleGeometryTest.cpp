@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "TriangleGeometry.h"
+#include "RobustPredicates.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Not a multiple of four, so the kernel's leftover triangles are covered too
+#define TRIANGLE_GEOMETRY_TEST_TRIANGLES 1003
+
+// Fills a batch with random triangles in a box of the given half size
+template<typename T>
+static void FillRandomTriangles(TTriangleBatch<T>& Batch, int32 Num, double HalfSize)
+{
+	FRandomStream Random(1234);
+	auto RandomPoint = [&Random, HalfSize]()
+	{
+		return FVector(Random.FRandRange(-HalfSize, HalfSize), Random.FRandRange(-HalfSize, HalfSize), Random.FRandRange(-HalfSize, HalfSize));
+	};
+
+	Batch.SetNum(Num);
+	for (int32 i = 0; i < Num; i++)
+	{
+		Batch.SetTriangle(i, RandomPoint(), RandomPoint(), RandomPoint());
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTriangleBatchMatchesReferenceTest, "ParticleOutput.TriangleGeometry.BatchMatchesReference", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTriangleBatchMatchesReferenceTest::RunTest(const FString& Parameters)
+{
+	// ComputeScalar runs MeshKit's tricircumcenter3d on every triangle, so it is the reference here
+	FTriangleBatch Batch;
+	FillRandomTriangles(Batch, TRIANGLE_GEOMETRY_TEST_TRIANGLES, 100.0);
+	TestTrue(TEXT("Double batch matches tricircumcenter3d"), Batch.ComputeAndValidate() < 1e-9);
+
+	FTriangleBatch3f FloatBatch;
+	FillRandomTriangles(FloatBatch, TRIANGLE_GEOMETRY_TEST_TRIANGLES, 100.0);
+	// Float rounding is amplified on thin triangles the error bound still lets through
+	TestTrue(TEXT("Float batch matches tricircumcenter3d"), FloatBatch.ComputeAndValidate() < 1e-2);
+
+	// Every circumcenter is as far from all three corners
+	int32 Unequal = 0;
+	for (int32 i = 0; i < Batch.Num(); i++)
+	{
+		const FVector Center = Batch.Circumcenter.Get(i);
+		const double Radius = Batch.CircumRadius[i];
+		const double Tolerance = 1e-6 * FMath::Max(Radius, 1.0);
+		if (!FMath::IsNearlyEqual(FVector::Dist(Center, Batch.A.Get(i)), Radius, Tolerance)
+			|| !FMath::IsNearlyEqual(FVector::Dist(Center, Batch.B.Get(i)), Radius, Tolerance)
+			|| !FMath::IsNearlyEqual(FVector::Dist(Center, Batch.C.Get(i)), Radius, Tolerance)) {
+			Unequal++;
+		}
+	}
+	TestEqual(TEXT("Circumcenters off their circle"), Unequal, 0);
+
+	// A right triangle has its circumcenter on the middle of the hypotenuse
+	FTriangleBatch Right;
+	Right.SetNum(1);
+	Right.SetTriangle(0, FVector(0, 0, 0), FVector(2, 0, 0), FVector(0, 2, 0));
+	Right.Compute();
+	TestTrue(TEXT("Right triangle circumcenter"), Right.Circumcenter.Get(0).Equals(FVector(1, 1, 0), 1e-12));
+	TestTrue(TEXT("Right triangle radius"), FMath::IsNearlyEqual(Right.CircumRadius[0], UE_DOUBLE_SQRT_2, 1e-12));
+	TestTrue(TEXT("Right triangle normal"), Right.Normal.Get(0).Equals(FVector(0, 0, 1), 1e-12));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTriangleBatchCollinearTest, "ParticleOutput.TriangleGeometry.CollinearTriangles", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTriangleBatchCollinearTest::RunTest(const FString& Parameters)
+{
+	// Degenerate triangles share a register with ordinary ones, so the per lane fallback is what runs
+	FTriangleBatch Batch;
+	Batch.SetNum(8);
+	Batch.SetTriangle(0, FVector(0, 0, 0), FVector(2, 0, 0), FVector(0, 2, 0));
+	Batch.SetTriangle(1, FVector(0, 0, 0), FVector(1, 1, 1), FVector(3, 3, 3));
+	Batch.SetTriangle(2, FVector(5, 5, 5), FVector(5, 5, 5), FVector(5, 5, 5));
+	Batch.SetTriangle(3, FVector(1, 0, 0), FVector(0, 1, 0), FVector(0, 0, 1));
+	Batch.SetTriangle(4, FVector(-4, 2, 0), FVector(6, 2, 0), FVector(1, 2, 0));
+	Batch.SetTriangle(5, FVector(0, 0, 0), FVector(1e8, 1, 0), FVector(2e8, 2, 0));
+	Batch.SetTriangle(6, FVector(0, 0, 0), FVector(1, 1e-9, 0), FVector(2, 0, 0));
+	Batch.SetTriangle(7, FVector(3, 1, 2), FVector(-1, 4, 0), FVector(2, 2, 5));
+	TestTrue(TEXT("Batch with collinear triangles matches tricircumcenter3d"), Batch.ComputeAndValidate() < 1e-9);
+
+	for (int32 i = 0; i < Batch.Num(); i++)
+	{
+		TestTrue(FString::Printf(TEXT("Triangle %i circumcenter is finite"), i), !Batch.Circumcenter.Get(i).ContainsNaN());
+		TestTrue(FString::Printf(TEXT("Triangle %i Euler line is finite"), i), !Batch.EulerLine.Get(i).ContainsNaN());
+		TestTrue(FString::Printf(TEXT("Triangle %i radius is finite"), i), FMath::IsFinite(Batch.CircumRadius[i]));
+	}
+
+	// Collinear corners fall back to the middle of the two furthest apart, with no normal
+	TestTrue(TEXT("Collinear circumcenter"), Batch.Circumcenter.Get(1).Equals(FVector(1.5, 1.5, 1.5), 1e-12));
+	TestTrue(TEXT("Collinear radius"), FMath::IsNearlyEqual(Batch.CircumRadius[1], FVector(3, 3, 3).Size() * 0.5, 1e-12));
+	TestTrue(TEXT("Collinear normal"), Batch.Normal.Get(1).IsZero());
+	TestTrue(TEXT("Collinear with the furthest pair last"), Batch.Circumcenter.Get(4).Equals(FVector(1, 2, 0), 1e-12));
+	TestTrue(TEXT("Coincident corners"), Batch.Circumcenter.Get(2).Equals(FVector(5, 5, 5), 1e-12) && Batch.CircumRadius[2] == 0.0);
+	TestTrue(TEXT("Collinear at large scale"), Batch.Normal.Get(5).IsZero());
+
+	// Nearly collinear is still a triangle, with its circumcenter far out on the bisector
+	TestTrue(TEXT("Nearly collinear keeps its normal"), Batch.Normal.Get(6).Equals(FVector(0, 0, -1), 1e-9));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTriangleBatchAxisPlaneTest, "ParticleOutput.TriangleGeometry.AxisPlaneTriangles", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTriangleBatchAxisPlaneTest::RunTest(const FString& Parameters)
+{
+	// Triangles flat in each coordinate plane have two cross components that are exactly zero.
+	// They are still ordinary triangles, so the vector kernel keeps them
+	FTriangleBatch Batch;
+	Batch.SetNum(12);
+	for (int32 i = 0; i < 4; i++)
+	{
+		const double Scale = 1.0 + i;
+		Batch.SetTriangle(i, FVector(0, 0, 5), FVector(3, 1, 5) * FVector(Scale, Scale, 1), FVector(1, 4, 5) * FVector(Scale, Scale, 1));
+		Batch.SetTriangle(i + 4, FVector(0, -2, 0), FVector(3, -2, 1) * FVector(Scale, 1, Scale), FVector(1, -2, 4) * FVector(Scale, 1, Scale));
+		Batch.SetTriangle(i + 8, FVector(7, 0, 0), FVector(7, 3, 1) * FVector(1, Scale, Scale), FVector(7, 1, 4) * FVector(1, Scale, Scale));
+	}
+
+	FRobustPredicates::ResetStats();
+	Batch.Compute();
+	const FRobustPredicates::FStats Stats = FRobustPredicates::GetStats();
+	TestEqual(TEXT("Every orient2d filtered by the kernel"), Stats.Orient2DCalls, uint64(Batch.Num() * 3));
+	TestEqual(TEXT("No exact predicates"), Stats.Orient2DExact, uint64(0));
+
+	// The scalar path evaluates each cross component once, for both the normal and the circumcenter
+	FRobustPredicates::ResetStats();
+	Batch.ComputeScalar();
+	TestEqual(TEXT("Three orient2d per scalar triangle"), FRobustPredicates::GetStats().Orient2DCalls, uint64(Batch.Num() * 3));
+
+	TestTrue(TEXT("Axis plane triangles match tricircumcenter3d"), Batch.ComputeAndValidate() < 1e-9);
+	TestTrue(TEXT("XY normal"), Batch.Normal.Get(0).Equals(FVector(0, 0, 1), 1e-12));
+	TestTrue(TEXT("XZ normal"), Batch.Normal.Get(4).Equals(FVector(0, -1, 0), 1e-12));
+	TestTrue(TEXT("YZ normal"), Batch.Normal.Get(8).Equals(FVector(1, 0, 0), 1e-12));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "TriangleHistory.h"
+#include "TauStateBank.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTriangleHistoryWrapTest, "ParticleOutput.TriangleHistory.Wraparound", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTriangleHistoryWrapTest::RunTest(const FString& Parameters)
+{
+	TTriangleHistory<int32> History;
+	History.Init(3, 4);
+	const SIZE_T AllocatedSize = History.GetAllocatedSize();
+
+	// Ten entries into a ring of four, each one past the fourth evicting the oldest
+	int32 Evictions = 0;
+	int32 WrongEvictions = 0;
+	for (int32 Value = 0; Value < 10; Value++)
+	{
+		int32 Evicted = INDEX_NONE;
+		if (History.Add(1, Value, &Evicted)) {
+			Evictions++;
+			WrongEvictions += Evicted != Value - 4 ? 1 : 0;
+		}
+	}
+	TestEqual(TEXT("Entries evicted"), Evictions, 6);
+	TestEqual(TEXT("Evicted entries that were not the oldest"), WrongEvictions, 0);
+
+	TestEqual(TEXT("Entries kept"), History.Num(1), 4);
+	TestEqual(TEXT("Newest entry"), History.Last(1), 9);
+	TestEqual(TEXT("Oldest entry"), History.Last(1, 3), 6);
+	TestEqual(TEXT("Entries oldest first"), History.ToArray(1), TArray<int32>({ 6, 7, 8, 9 }));
+
+	// Neighbouring triangles share the array but not their rings
+	TestEqual(TEXT("Triangle before untouched"), History.Num(0), 0);
+	TestEqual(TEXT("Triangle after untouched"), History.Num(2), 0);
+	History.Add(2, 42);
+	TestEqual(TEXT("Triangle after holds its own entry"), History.ToArray(2), TArray<int32>({ 42 }));
+	TestEqual(TEXT("Triangle before still holds its entries"), History.ToArray(1), TArray<int32>({ 6, 7, 8, 9 }));
+
+	TestEqual(TEXT("Allocated size after adding"), History.GetAllocatedSize(), AllocatedSize);
+
+	// A capacity of one always holds just the newest entry
+	TTriangleHistory<int32> Single;
+	Single.Init(1, 0);
+	Single.Add(0, 1);
+	Single.Add(0, 2);
+	TestEqual(TEXT("Capacity of one"), Single.ToArray(0), TArray<int32>({ 2 }));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTauStateBankBoundedTest, "ParticleOutput.TriangleHistory.TauStateBankStaysBounded", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FTauStateBankBoundedTest::RunTest(const FString& Parameters)
+{
+	const int32 NumTriangles = 67;
+	TArray<FVector> MeasuringSticks;
+	TArray<FVector> EulerLines;
+	TArray<int32> Triangles;
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		MeasuringSticks.Add(FVector(10.0, 0.0, 0.0));
+		EulerLines.Add(FVector(1.0, 0.0, 0.0));
+		Triangles.Add(i);
+	}
+
+	FTauStateBank Bank;
+	Bank.Begin(MeasuringSticks, EulerLines, 0.0);
+
+	// Each Euler line turns a little every frame, at its own rate
+	auto Advance = [&](int32 Frame)
+	{
+		for (int32 i = 0; i < NumTriangles; i++)
+		{
+			const double Angle = Frame * 0.01 * (1 + i % 5);
+			EulerLines[i] = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.1 * i);
+		}
+		Bank.Update(Triangles, EulerLines, Frame / 60.0);
+	};
+
+	// The first frames size the batched update's scratch arrays
+	int32 Frame = 1;
+	for (; Frame <= 8; Frame++)
+	{
+		Advance(Frame);
+	}
+	const SIZE_T AllocatedSize = Bank.GetAllocatedSize();
+
+	// Enough frames to fill the motion path and every coarse reading behind it
+	const int32 NumFrames = Bank.MotionPathWindow + Bank.CoarseMotionPathWindow * Bank.CoarseMotionPathStride + 100;
+	for (; Frame <= NumFrames; Frame++)
+	{
+		Advance(Frame);
+	}
+
+	TestEqual(TEXT("Allocated size after every history has wrapped"), Bank.GetAllocatedSize(), AllocatedSize);
+	TestEqual(TEXT("Motion path readings"), Bank.MotionPath.Num(0), Bank.MotionPathWindow);
+	TestEqual(TEXT("Coarse motion path readings"), Bank.CoarseMotionPath.Num(0), Bank.CoarseMotionPathWindow);
+	TestEqual(TEXT("Tau samples"), Bank.IncrementalTauSamples.Num(0), Bank.SampleWindow);
+	TestEqual(TEXT("Newest reading time"), Bank.MotionPath.Last(0).W, NumFrames / 60.0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTriangleHistorySoakTest, "ParticleOutput.TriangleHistory.Soak", EAutomationTestFlags::EditorContext | EAutomationTestFlags::StressFilter)
+
+bool FTriangleHistorySoakTest::RunTest(const FString& Parameters)
+{
+	// Ten million entries into rings of seven, so every head wraps well over a million times.
+	// Triangle t holds every third value from t, so each eviction is the value 21 before
+	TTriangleHistory<int32> History;
+	History.Init(3, 7);
+	const SIZE_T AllocatedSize = History.GetAllocatedSize();
+	const int32 NumValues = 10000000;
+	int32 WrongEvictions = 0;
+	for (int32 Value = 0; Value < NumValues; Value++)
+	{
+		int32 Evicted = INDEX_NONE;
+		if (History.Add(Value % 3, Value, &Evicted)) {
+			WrongEvictions += Evicted != Value - 21 ? 1 : 0;
+		}
+	}
+	TestEqual(TEXT("Evicted entries that were not the oldest"), WrongEvictions, 0);
+	TestEqual(TEXT("Allocated size after every entry"), History.GetAllocatedSize(), AllocatedSize);
+	TestEqual(TEXT("Newest entries last"), History.ToArray(0), TArray<int32>({ 9999981, 9999984, 9999987, 9999990, 9999993, 9999996, 9999999 }));
+
+	// Half an hour of tracking at the default 120 readings a second, over 14 million triangle readings
+	const int32 NumTriangles = 67;
+	const int32 NumReadings = 120 * 60 * 30;
+	TArray<FVector> MeasuringSticks;
+	TArray<FVector> EulerLines;
+	TArray<int32> Triangles;
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		MeasuringSticks.Add(FVector(10.0, 0.0, 0.0));
+		EulerLines.Add(FVector(1.0, 0.0, 0.0));
+		Triangles.Add(i);
+	}
+
+	FTauStateBank Bank;
+	Bank.Begin(MeasuringSticks, EulerLines, 0.0);
+	SIZE_T BankSize = 0;
+	int32 SizeChanges = 0;
+	int32 MisorderedReadings = 0;
+	for (int32 Reading = 1; Reading <= NumReadings; Reading++)
+	{
+		for (int32 i = 0; i < NumTriangles; i++)
+		{
+			const double Angle = Reading * 0.005 * (1 + i % 5);
+			EulerLines[i] = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.1 * i);
+		}
+		Bank.Update(Triangles, EulerLines, Reading / 120.0);
+
+		// The first readings size the batched update's scratch arrays, nothing grows after them.
+		// Each check also walks one triangle's motion path, which has to hold the newest readings in order
+		if (Reading % 10000 == 0) {
+			const SIZE_T Size = Bank.GetAllocatedSize();
+			SizeChanges += BankSize != 0 && Size != BankSize ? 1 : 0;
+			BankSize = Size;
+
+			const TArray<FVector4> MotionPath = Bank.MotionPath.ToArray((Reading / 10000) % NumTriangles);
+			for (int32 k = 0; k < MotionPath.Num(); k++)
+			{
+				MisorderedReadings += MotionPath[k].W != (Reading - MotionPath.Num() + 1 + k) / 120.0 ? 1 : 0;
+			}
+		}
+	}
+
+	TestEqual(TEXT("Bank size changes"), SizeChanges, 0);
+	TestEqual(TEXT("Motion path readings out of order"), MisorderedReadings, 0);
+	TestEqual(TEXT("Motion path readings"), Bank.MotionPath.Num(0), Bank.MotionPathWindow);
+	TestEqual(TEXT("Coarse motion path readings"), Bank.CoarseMotionPath.Num(0), Bank.CoarseMotionPathWindow);
+	TestEqual(TEXT("Newest reading time"), Bank.MotionPath.Last(NumTriangles - 1).W, NumReadings / 120.0);
+	TestTrue(TEXT("Coarse readings older than the motion path"), Bank.CoarseMotionPath.Last(0).W < Bank.MotionPath.Last(0, Bank.MotionPathWindow - 1).W);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,475 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TriangleGeometry.h"
+#include "RobustPredicates.h"
+#include "Math/VectorRegister.h"
+#include "Async/ParallelFor.h"
+
+// Triangles per block when a batch is split across worker threads
+#define TRIANGLE_BATCH_BLOCK_SIZE 1024
+
+// Below this many triangles the batch is computed on the calling thread
+#define TRIANGLE_BATCH_PARALLEL_THRESHOLD 4096
+
+// Vector register type and constants of the kernel for each storage type
+template<typename T>
+struct TLaneTraits;
+
+template<>
+struct TLaneTraits<double>
+{
+	typedef VectorRegister4Double FRegister;
+
+	static double Orient2DErrorBound() { return FRobustPredicates::Orient2DErrorBound; }
+
+	static FORCEINLINE FRegister Splat(double Value) { return MakeVectorRegisterDouble(Value, Value, Value, Value); }
+};
+
+template<>
+struct TLaneTraits<float>
+{
+	typedef VectorRegister4Float FRegister;
+
+	// The same bound as FRobustPredicates::Orient2DErrorBound, for float rounding (epsilon 2^-24)
+	static float Orient2DErrorBound() { return (3.0f + 16.0f * 5.9604645e-08f) * 5.9604645e-08f; }
+
+	static FORCEINLINE FRegister Splat(float Value) { return MakeVectorRegisterFloat(Value, Value, Value, Value); }
+};
+
+// Four triangles' worth of one vector quantity
+template<typename T>
+struct TVectorLanes
+{
+	typedef typename TLaneTraits<T>::FRegister FRegister;
+	FRegister X, Y, Z;
+};
+
+template<typename T>
+static FORCEINLINE TVectorLanes<T> LoadLanes(const TTriangleVectorStream<T>& Stream, int32 Index)
+{
+	return { VectorLoad(Stream.X.GetData() + Index), VectorLoad(Stream.Y.GetData() + Index), VectorLoad(Stream.Z.GetData() + Index) };
+}
+
+template<typename T>
+static FORCEINLINE void StoreLanes(TTriangleVectorStream<T>& Stream, int32 Index, const TVectorLanes<T>& Lanes)
+{
+	VectorStore(Lanes.X, Stream.X.GetData() + Index);
+	VectorStore(Lanes.Y, Stream.Y.GetData() + Index);
+	VectorStore(Lanes.Z, Stream.Z.GetData() + Index);
+}
+
+template<typename T>
+static FORCEINLINE TVectorLanes<T> AddLanes(const TVectorLanes<T>& L, const TVectorLanes<T>& R)
+{
+	return { VectorAdd(L.X, R.X), VectorAdd(L.Y, R.Y), VectorAdd(L.Z, R.Z) };
+}
+
+template<typename T>
+static FORCEINLINE TVectorLanes<T> SubtractLanes(const TVectorLanes<T>& L, const TVectorLanes<T>& R)
+{
+	return { VectorSubtract(L.X, R.X), VectorSubtract(L.Y, R.Y), VectorSubtract(L.Z, R.Z) };
+}
+
+template<typename T>
+static FORCEINLINE TVectorLanes<T> ScaleLanes(const TVectorLanes<T>& L, const typename TVectorLanes<T>::FRegister& Scale)
+{
+	return { VectorMultiply(L.X, Scale), VectorMultiply(L.Y, Scale), VectorMultiply(L.Z, Scale) };
+}
+
+template<typename T>
+static FORCEINLINE TVectorLanes<T> CrossLanes(const TVectorLanes<T>& L, const TVectorLanes<T>& R)
+{
+	return {
+		VectorSubtract(VectorMultiply(L.Y, R.Z), VectorMultiply(L.Z, R.Y)),
+		VectorSubtract(VectorMultiply(L.Z, R.X), VectorMultiply(L.X, R.Z)),
+		VectorSubtract(VectorMultiply(L.X, R.Y), VectorMultiply(L.Y, R.X)) };
+}
+
+template<typename T>
+static FORCEINLINE typename TVectorLanes<T>::FRegister DotLanes(const TVectorLanes<T>& L, const TVectorLanes<T>& R)
+{
+	return VectorMultiplyAdd(L.Z, R.Z, VectorMultiplyAdd(L.Y, R.Y, VectorMultiply(L.X, R.X)));
+}
+
+// Largest rounding error of a * b - c * d, given the two products, relative to |a * b| + |c * d|
+template<typename FRegister>
+static FORCEINLINE FRegister OrientError(const FRegister& Left, const FRegister& Right, const FRegister& ErrorBound)
+{
+	return VectorMultiply(ErrorBound, VectorAdd(VectorAbs(Left), VectorAbs(Right)));
+}
+
+// Circumcenter below from circumcenter.cpp in MeshKit   https://bitbucket.org/fathomteam/meshkit.git
+// It is the scalar reference the vectorized kernel is checked against, always with exact predicates
+
+static double orient2d(const double* pa, const double* pb, const double* pc)
+{
+	return FRobustPredicates::Orient2D(pa, pb, pc);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  tricircumcenter3d()   Find the circumcenter of a triangle in 3D.         */
+/*                                                                           */
+/*  The result is returned both in terms of xyz coordinates and xi-eta       */
+/*  coordinates, relative to the triangle's point `a' (that is, `a' is       */
+/*  the origin of both coordinate systems).  Hence, the xyz coordinates      */
+/*  returned are NOT absolute; one must add the coordinates of `a' to        */
+/*  find the absolute coordinates of the circumcircle.  However, this means  */
+/*  that the result is frequently more accurate than would be possible if    */
+/*  absolute coordinates were returned, due to limited floating-point        */
+/*  precision.  In general, the circumradius can be computed much more       */
+/*  accurately.                                                              */
+/*                                                                           */
+/*  The xi-eta coordinate system is defined in terms of the triangle.        */
+/*  Point `a' is the origin of the coordinate system.  The edge `ab' extends */
+/*  one unit along the xi axis.  The edge `ac' extends one unit along the    */
+/*  eta axis.  These coordinate values are useful for linear interpolation.  */
+/*                                                                           */
+/*  If `xi' is NULL on input, the xi-eta coordinates will not be computed.   */
+/*                                                                           */
+/*  The cross product of the edges from `a' is passed in, since the caller   */
+/*  already computed it with orient2d() for the normal and bisectors.        */
+/*                                                                           */
+/*****************************************************************************/
+/*****************************************************************************/
+static void tricircumcenter3d(const double a[3], const double b[3], const double c[3],
+	double xcrossbc, double ycrossbc, double zcrossbc, double circumcenter[3], double* xi, double* eta)
+{
+	double xba, yba, zba, xca, yca, zca;
+	double balength, calength;
+	double denominator;
+	double xcirca, ycirca, zcirca;
+
+	/* Use coordinates relative to point `a' of the triangle. */
+	xba = b[0] - a[0];
+	yba = b[1] - a[1];
+	zba = b[2] - a[2];
+	xca = c[0] - a[0];
+	yca = c[1] - a[1];
+	zca = c[2] - a[2];
+	/* Squares of lengths of the edges incident to `a'. */
+	balength = xba * xba + yba * yba + zba * zba;
+	calength = xca * xca + yca * yca + zca * zca;
+
+	/* Calculate the denominator of the formulae. */
+	denominator = 0.5 / (xcrossbc * xcrossbc + ycrossbc * ycrossbc +
+		zcrossbc * zcrossbc);
+
+	/* Calculate offset (from `a') of circumcenter. */
+	xcirca = ((balength * yca - calength * yba) * zcrossbc -
+		(balength * zca - calength * zba) * ycrossbc) * denominator;
+	ycirca = ((balength * zca - calength * zba) * xcrossbc -
+		(balength * xca - calength * xba) * zcrossbc) * denominator;
+	zcirca = ((balength * xca - calength * xba) * ycrossbc -
+		(balength * yca - calength * yba) * xcrossbc) * denominator;
+	circumcenter[0] = xcirca;
+	circumcenter[1] = ycirca;
+	circumcenter[2] = zcirca;
+
+	if (xi != (double*)NULL) {
+		/* To interpolate a linear function at the circumcenter, define a     */
+		/*   coordinate system with a xi-axis directed from `a' to `b' and    */
+		/*   an eta-axis directed from `a' to `c'.  The values for xi and eta */
+		/*   are computed by Cramer's Rule for solving systems of linear      */
+		/*   equations.                                                       */
+
+		/* There are three ways to do this calculation - using xcrossbc, */
+		/*   ycrossbc, or zcrossbc.  Choose whichever has the largest    */
+		/*   magnitude, to improve stability and avoid division by zero. */
+		if (((xcrossbc >= ycrossbc) ^ (-xcrossbc > ycrossbc)) &&
+			((xcrossbc >= zcrossbc) ^ (-xcrossbc > zcrossbc))) {
+			*xi = (ycirca * zca - zcirca * yca) / xcrossbc;
+			*eta = (zcirca * yba - ycirca * zba) / xcrossbc;
+		}
+		else if ((ycrossbc >= zcrossbc) ^ (-ycrossbc > zcrossbc)) {
+			*xi = (zcirca * xca - xcirca * zca) / ycrossbc;
+			*eta = (xcirca * zba - zcirca * xba) / ycrossbc;
+		}
+		else {
+			*xi = (xcirca * yca - ycirca * xca) / zcrossbc;
+			*eta = (ycirca * xba - xcirca * yba) / zcrossbc;
+		}
+	}
+}
+
+template<typename T>
+void TTriangleBatch<T>::SetNum(int32 InNum)
+{
+	NumTriangles = InNum;
+	FStream* Streams[] = {
+		&A, &B, &C,
+		&EdgeAB, &EdgeBC, &EdgeCA,
+		&MidpointAB, &MidpointBC, &MidpointCA,
+		&Normal, &BisectorAB, &BisectorBC, &BisectorCA,
+		&Centroid, &Circumcenter, &EulerLine
+	};
+	for (FStream* Stream : Streams)
+	{
+		Stream->SetNum(InNum);
+	}
+	CircumRadius.SetNumUninitialized(InNum, false);
+}
+
+template<typename T>
+void TTriangleBatch<T>::Compute()
+{
+	if (NumTriangles < TRIANGLE_BATCH_PARALLEL_THRESHOLD) {
+		ComputeRange(0, NumTriangles);
+		return;
+	}
+
+	const int32 NumBlocks = FMath::DivideAndRoundUp(NumTriangles, TRIANGLE_BATCH_BLOCK_SIZE);
+	ParallelFor(NumBlocks, [this](int32 Block)
+	{
+		const int32 First = Block * TRIANGLE_BATCH_BLOCK_SIZE;
+		ComputeRange(First, FMath::Min(First + TRIANGLE_BATCH_BLOCK_SIZE, NumTriangles));
+	});
+}
+
+template<typename T>
+void TTriangleBatch<T>::ComputeScalar()
+{
+	ComputeScalarRange(0, NumTriangles);
+}
+
+template<typename T>
+void TTriangleBatch<T>::ComputeRange(int32 First, int32 Last)
+{
+	typedef TLaneTraits<T> FTraits;
+	typedef TVectorLanes<T> FVectorLanes;
+	typedef typename FTraits::FRegister FRegister;
+
+	const FRegister Third = FTraits::Splat(T(1.0 / 3.0));
+	const FRegister Half = FTraits::Splat(T(0.5));
+	const FRegister ErrorBound = FTraits::Splat(FTraits::Orient2DErrorBound());
+	TArray<int32, TInlineAllocator<16>> Fallbacks;
+
+	int32 i = First;
+	for (; i + 4 <= Last; i += 4)
+	{
+		const FVectorLanes Va = LoadLanes(A, i);
+		const FVectorLanes Vb = LoadLanes(B, i);
+		const FVectorLanes Vc = LoadLanes(C, i);
+
+		// Edges and midpoints
+		const FVectorLanes AB = SubtractLanes(Va, Vb);
+		const FVectorLanes BC = SubtractLanes(Vb, Vc);
+		const FVectorLanes CA = SubtractLanes(Vc, Va);
+		StoreLanes(EdgeAB, i, AB);
+		StoreLanes(EdgeBC, i, BC);
+		StoreLanes(EdgeCA, i, CA);
+		StoreLanes(MidpointAB, i, ScaleLanes(AddLanes(Va, Vb), Half));
+		StoreLanes(MidpointBC, i, ScaleLanes(AddLanes(Vb, Vc), Half));
+		StoreLanes(MidpointCA, i, ScaleLanes(AddLanes(Vc, Va), Half));
+
+		// Centroid
+		const FVectorLanes G = ScaleLanes(AddLanes(AddLanes(Va, Vb), Vc), Third);
+		StoreLanes(Centroid, i, G);
+
+		// Edges from A and their squared lengths
+		const FVectorLanes BA = SubtractLanes(Vb, Va);
+		const FVectorLanes CAfromA = SubtractLanes(Vc, Va);
+		const FRegister balength = DotLanes(BA, BA);
+		const FRegister calength = DotLanes(CAfromA, CAfromA);
+
+		// (b - a) x (c - a), which is also EdgeAB x EdgeBC. Each component is an orient2d of a
+		// projection of the triangle. Where their rounding errors together could exceed the length
+		// of the cross product, the lane is redone by the scalar path with exact predicates. A
+		// component that is small next to the others, as in a triangle lying in a coordinate
+		// plane, barely moves the normal and does not need to be exact
+		const FVectorLanes Cross = CrossLanes(BA, CAfromA);
+		const FRegister xerror = OrientError(VectorMultiply(BA.Y, CAfromA.Z), VectorMultiply(CAfromA.Y, BA.Z), ErrorBound);
+		const FRegister yerror = OrientError(VectorMultiply(BA.Z, CAfromA.X), VectorMultiply(CAfromA.Z, BA.X), ErrorBound);
+		const FRegister zerror = OrientError(VectorMultiply(BA.X, CAfromA.Y), VectorMultiply(CAfromA.X, BA.Y), ErrorBound);
+		const FRegister CrossError = VectorAdd(VectorAdd(xerror, yerror), zerror);
+		const FRegister CrossLength = DotLanes(Cross, Cross);
+		T Slack[4];
+		VectorStore(VectorSubtract(CrossLength, VectorMultiply(CrossError, CrossError)), Slack);
+
+		// Normal and bisector directions, normalized after the loop
+		StoreLanes(Normal, i, Cross);
+		StoreLanes(BisectorAB, i, CrossLanes(Cross, AB));
+		StoreLanes(BisectorBC, i, CrossLanes(Cross, BC));
+		StoreLanes(BisectorCA, i, CrossLanes(Cross, CA));
+
+		// Offset of the circumcenter from A
+		const FRegister denominator = VectorDivide(Half, CrossLength);
+		const FVectorLanes Lengths = SubtractLanes(ScaleLanes(CAfromA, balength), ScaleLanes(BA, calength));
+		const FVectorLanes Offset = ScaleLanes(CrossLanes(Lengths, Cross), denominator);
+		const FVectorLanes O = AddLanes(Va, Offset);
+		StoreLanes(Circumcenter, i, O);
+		VectorStore(DotLanes(Offset, Offset), CircumRadius.GetData() + i);
+		StoreLanes(EulerLine, i, SubtractLanes(G, O));
+
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			if (!(Slack[Lane] > T(0))) {
+				Fallbacks.Add(i + Lane);
+			}
+		}
+	}
+
+	// Square roots run as their own loops so they vectorize. The radius was stored squared
+	for (int32 j = First; j < i; j++)
+	{
+		CircumRadius[j] = FMath::Sqrt(CircumRadius[j]);
+	}
+	NormalizeRange(First, i);
+
+	for (int32 Fallback : Fallbacks)
+	{
+		ComputeScalarRange(Fallback, Fallback + 1);
+	}
+	FRobustPredicates::RecordFilteredOrient2D(uint64(i - First - Fallbacks.Num()) * 3);
+
+	// Leftover triangles that do not fill a register
+	ComputeScalarRange(i, Last);
+}
+
+template<typename T>
+void TTriangleBatch<T>::NormalizeRange(int32 First, int32 Last)
+{
+	FStream* Directions[] = { &Normal, &BisectorAB, &BisectorBC, &BisectorCA };
+	for (FStream* Direction : Directions)
+	{
+		T* X = Direction->X.GetData();
+		T* Y = Direction->Y.GetData();
+		T* Z = Direction->Z.GetData();
+		for (int32 i = First; i < Last; i++)
+		{
+			const T LengthSquared = X[i] * X[i] + Y[i] * Y[i] + Z[i] * Z[i];
+			const T Scale = LengthSquared > T(0) ? T(1) / FMath::Sqrt(LengthSquared) : T(0);
+			X[i] *= Scale;
+			Y[i] *= Scale;
+			Z[i] *= Scale;
+		}
+	}
+}
+
+// Float batches are widened to double here, so the exact predicates see the stored values
+template<typename T>
+void TTriangleBatch<T>::ComputeScalarRange(int32 First, int32 Last)
+{
+	for (int32 i = First; i < Last; i++)
+	{
+		const double a[3] = { A.X[i], A.Y[i], A.Z[i] };
+		const double b[3] = { B.X[i], B.Y[i], B.Z[i] };
+		const double c[3] = { C.X[i], C.Y[i], C.Z[i] };
+
+		EdgeAB.Set(i, FVector(a[0] - b[0], a[1] - b[1], a[2] - b[2]));
+		EdgeBC.Set(i, FVector(b[0] - c[0], b[1] - c[1], b[2] - c[2]));
+		EdgeCA.Set(i, FVector(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+		MidpointAB.Set(i, FVector((a[0] + b[0]) * 0.5, (a[1] + b[1]) * 0.5, (a[2] + b[2]) * 0.5));
+		MidpointBC.Set(i, FVector((b[0] + c[0]) * 0.5, (b[1] + c[1]) * 0.5, (b[2] + c[2]) * 0.5));
+		MidpointCA.Set(i, FVector((c[0] + a[0]) * 0.5, (c[1] + a[1]) * 0.5, (c[2] + a[2]) * 0.5));
+		Centroid.Set(i, FVector((a[0] + b[0] + c[0]) * (1.0 / 3.0), (a[1] + b[1] + c[1]) * (1.0 / 3.0), (a[2] + b[2] + c[2]) * (1.0 / 3.0)));
+
+		/* Use coordinates relative to point `a' of the triangle. */
+		const double xba = b[0] - a[0];
+		const double yba = b[1] - a[1];
+		const double zba = b[2] - a[2];
+		const double xca = c[0] - a[0];
+		const double yca = c[1] - a[1];
+		const double zca = c[2] - a[2];
+		/* Squares of lengths of the edges incident to `a'. */
+		const double balength = xba * xba + yba * yba + zba * zba;
+		const double calength = xca * xca + yca * yca + zca * zca;
+
+		/* Cross product of these edges, each component an orient2d of a projection. */
+		/* Use orient2d() from http://www.cs.cmu.edu/~quake/robust.html     */
+		/*   to ensure a correctly signed (and reasonably accurate) result, */
+		/*   avoiding any possibility of division by zero.                  */
+		double PA[2], PB[2], PC[2];
+
+		PA[0] = b[1]; PA[1] = b[2];
+		PB[0] = c[1]; PB[1] = c[2];
+		PC[0] = a[1]; PC[1] = a[2];
+		const double xcrossbc = orient2d(PA, PB, PC);
+
+		PA[0] = c[0]; PA[1] = c[2];
+		PB[0] = b[0]; PB[1] = b[2];
+		PC[0] = a[0]; PC[1] = a[2];
+		const double ycrossbc = orient2d(PA, PB, PC);
+
+		PA[0] = b[0]; PA[1] = b[1];
+		PB[0] = c[0]; PB[1] = c[1];
+		PC[0] = a[0]; PC[1] = a[1];
+		const double zcrossbc = orient2d(PA, PB, PC);
+
+		const FVector Cross(xcrossbc, ycrossbc, zcrossbc);
+		Normal.Set(i, Cross);
+		BisectorAB.Set(i, FVector::CrossProduct(Cross, FVector(a[0] - b[0], a[1] - b[1], a[2] - b[2])));
+		BisectorBC.Set(i, FVector::CrossProduct(Cross, FVector(b[0] - c[0], b[1] - c[1], b[2] - c[2])));
+		BisectorCA.Set(i, FVector::CrossProduct(Cross, FVector(c[0] - a[0], c[1] - a[1], c[2] - a[2])));
+		NormalizeRange(i, i + 1);
+
+		const double crosslength = xcrossbc * xcrossbc + ycrossbc * ycrossbc + zcrossbc * zcrossbc;
+		if (crosslength == 0.0) {
+			// Collinear corners have no circumcircle. The smallest circle through the two
+			// furthest corners is used instead, so the Euler line stays finite.
+			const double cblength = FMath::Square(c[0] - b[0]) + FMath::Square(c[1] - b[1]) + FMath::Square(c[2] - b[2]);
+			const double* From = a;
+			const double* To = b;
+			double Longest = balength;
+			if (calength > Longest) {
+				To = c;
+				Longest = calength;
+			}
+			if (cblength > Longest) {
+				From = b;
+				To = c;
+				Longest = cblength;
+			}
+			Circumcenter.Set(i, FVector((From[0] + To[0]) * 0.5, (From[1] + To[1]) * 0.5, (From[2] + To[2]) * 0.5));
+			CircumRadius[i] = T(FMath::Sqrt(Longest) * 0.5);
+		}
+		else {
+			double circa[3];
+			tricircumcenter3d(a, b, c, xcrossbc, ycrossbc, zcrossbc, circa, nullptr, nullptr);
+			Circumcenter.Set(i, FVector(a[0] + circa[0], a[1] + circa[1], a[2] + circa[2]));
+			CircumRadius[i] = T(FMath::Sqrt(circa[0] * circa[0] + circa[1] * circa[1] + circa[2] * circa[2]));
+		}
+
+		EulerLine.Set(i, Centroid.Get(i) - Circumcenter.Get(i));
+	}
+}
+
+template<typename T>
+double TTriangleBatch<T>::ComputeAndValidate()
+{
+	TTriangleBatch Reference = *this;
+	Reference.ComputeScalar();
+	Compute();
+
+	TArray<TPair<const TArray<T>*, const TArray<T>*>, TInlineAllocator<64>> Results;
+	Results.Emplace(&CircumRadius, &Reference.CircumRadius);
+	FStream TTriangleBatch::* Streams[] = {
+		&TTriangleBatch::EdgeAB, &TTriangleBatch::EdgeBC, &TTriangleBatch::EdgeCA,
+		&TTriangleBatch::MidpointAB, &TTriangleBatch::MidpointBC, &TTriangleBatch::MidpointCA,
+		&TTriangleBatch::Normal, &TTriangleBatch::BisectorAB, &TTriangleBatch::BisectorBC, &TTriangleBatch::BisectorCA,
+		&TTriangleBatch::Centroid, &TTriangleBatch::Circumcenter, &TTriangleBatch::EulerLine
+	};
+	for (FStream TTriangleBatch::* Stream : Streams)
+	{
+		Results.Emplace(&(this->*Stream).X, &(Reference.*Stream).X);
+		Results.Emplace(&(this->*Stream).Y, &(Reference.*Stream).Y);
+		Results.Emplace(&(this->*Stream).Z, &(Reference.*Stream).Z);
+	}
+
+	double MaxDeviation = 0.0;
+	for (const TPair<const TArray<T>*, const TArray<T>*>& Result : Results)
+	{
+		const TArray<T>& Vectorized = *Result.Key;
+		const TArray<T>& Scalar = *Result.Value;
+		for (int32 i = 0; i < NumTriangles; i++)
+		{
+			const double Deviation = FMath::Abs(double(Vectorized[i]) - double(Scalar[i])) / FMath::Max(1.0, FMath::Abs(double(Scalar[i])));
+			MaxDeviation = FMath::Max(MaxDeviation, Deviation);
+		}
+	}
+	return MaxDeviation;
+}
+
+template struct TTriangleBatch<double>;
+template struct TTriangleBatch<float>;
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One vector quantity of every triangle in a batch, one array per component
+template<typename T>
+struct TTriangleVectorStream
+{
+	TArray<T> X, Y, Z;
+
+	void SetNum(int32 InNum)
+	{
+		X.SetNumUninitialized(InNum, false);
+		Y.SetNumUninitialized(InNum, false);
+		Z.SetNumUninitialized(InNum, false);
+	}
+
+	UE::Math::TVector<T> Get(int32 Index) const { return UE::Math::TVector<T>(X[Index], Y[Index], Z[Index]); }
+
+	template<typename U>
+	void Set(int32 Index, const UE::Math::TVector<U>& Value)
+	{
+		X[Index] = T(Value.X);
+		Y[Index] = T(Value.Y);
+		Z[Index] = T(Value.Z);
+	}
+};
+
+/*
+	Structure of arrays store for a batch of 3D triangles and everything derived
+	from them. Each component lives in its own contiguous array so the kernel
+	can process four triangles per vector register, and every quantity is
+	computed in a single pass over the vertices.
+
+	Circumcenters follow tricircumcenter3d from MeshKit, computed relative to
+	vertex A for accuracy. The Euler line is stored as centroid - circumcenter.
+	Triangles too close to degenerate for the kernel's rounding error bound are
+	recomputed with exact predicates (see RobustPredicates.h), and collinear
+	triangles use the midpoint of their longest edge as the circumcenter.
+
+	The batch is compiled for double and float storage. Float batches move half
+	the data through the kernel and are meant for coordinates kept small, such
+	as positions relative to the performer; exact fallbacks still run in double.
+*/
+template<typename T>
+struct TTriangleBatch
+{
+	typedef TTriangleVectorStream<T> FStream;
+
+	// Vertex positions
+	FStream A, B, C;
+
+	// Edge vectors A - B, B - C and C - A, and their midpoints
+	FStream EdgeAB, EdgeBC, EdgeCA;
+	FStream MidpointAB, MidpointBC, MidpointCA;
+
+	// Unit normal along EdgeAB x EdgeBC, zero for collinear triangles
+	FStream Normal;
+
+	// Unit in-plane directions of the perpendicular bisector of each edge (Normal x Edge)
+	FStream BisectorAB, BisectorBC, BisectorCA;
+
+	FStream Centroid;
+	FStream Circumcenter;
+	TArray<T> CircumRadius;
+	FStream EulerLine;
+
+	// Resizes every array, keeping the allocations when shrinking
+	void SetNum(int32 InNum);
+
+	int32 Num() const { return NumTriangles; }
+
+	template<typename U>
+	void SetTriangle(int32 Index, const UE::Math::TVector<U>& InA, const UE::Math::TVector<U>& InB, const UE::Math::TVector<U>& InC)
+	{
+		A.Set(Index, InA);
+		B.Set(Index, InB);
+		C.Set(Index, InC);
+	}
+
+	// Computes the results for every triangle with the vector kernel.
+	// Large batches are split into blocks processed in parallel.
+	void Compute();
+
+	// Computes the results one triangle at a time with exact predicates, the reference for Compute
+	void ComputeScalar();
+
+	// Runs both paths and returns the largest difference between their results,
+	// relative to the size of the values compared. Leaves the vector results in place.
+	double ComputeAndValidate();
+
+private:
+	void ComputeRange(int32 First, int32 Last);
+	void ComputeScalarRange(int32 First, int32 Last);
+
+	// Scales the normal and bisectors of a range to unit length
+	void NormalizeRange(int32 First, int32 Last);
+
+	int32 NumTriangles = 0;
+};
+
+// Both instantiations are compiled in TriangleGeometry.cpp
+extern template struct TTriangleBatch<double>;
+extern template struct TTriangleBatch<float>;
+
+typedef TTriangleVectorStream<double> FTriangleVectorStream;
+typedef TTriangleBatch<double> FTriangleBatch;
+typedef TTriangleBatch<float> FTriangleBatch3f;
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+	A fixed capacity history for every triangle of a bank, stored in one
+	contiguous array with each triangle's entries in a ring. Adding to a full
+	history overwrites its oldest entry, so memory never grows after Init.
+*/
+template<typename T>
+struct TTriangleHistory
+{
+	// Sizes the history for NumTriangles triangles of InCapacity entries each, all empty
+	void Init(int32 NumTriangles, int32 InCapacity)
+	{
+		Capacity = FMath::Max(InCapacity, 1);
+		Values.SetNumZeroed(NumTriangles * Capacity);
+		Heads.Init(0, NumTriangles);
+		Counts.Init(0, NumTriangles);
+	}
+
+	int32 Num(int32 Triangle) const { return Counts[Triangle]; }
+
+	int32 GetCapacity() const { return Capacity; }
+
+	// Adds the newest entry. Returns true when the history was full, with the overwritten entry in OutEvicted
+	bool Add(int32 Triangle, const T& Value, T* OutEvicted = nullptr)
+	{
+		T& Slot = Values[Triangle * Capacity + Heads[Triangle]];
+		const bool bFull = Counts[Triangle] == Capacity;
+		if (bFull && OutEvicted != nullptr) {
+			*OutEvicted = Slot;
+		}
+		Slot = Value;
+		Heads[Triangle] = (Heads[Triangle] + 1) % Capacity;
+		Counts[Triangle] = FMath::Min(Counts[Triangle] + 1, Capacity);
+		return bFull;
+	}
+
+	// Entry IndexFromTheEnd places before the newest, as TArray::Last
+	const T& Last(int32 Triangle, int32 IndexFromTheEnd = 0) const
+	{
+		check(IndexFromTheEnd >= 0 && IndexFromTheEnd < Counts[Triangle]);
+		return Values[Triangle * Capacity + (Heads[Triangle] - 1 - IndexFromTheEnd + Capacity) % Capacity];
+	}
+
+	// Every entry of a triangle, oldest first
+	TArray<T> ToArray(int32 Triangle) const
+	{
+		TArray<T> Result;
+		Result.SetNumUninitialized(Counts[Triangle]);
+		for (int32 i = 0; i < Counts[Triangle]; i++)
+		{
+			Result[i] = Last(Triangle, Counts[Triangle] - 1 - i);
+		}
+		return Result;
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Values.GetAllocatedSize() + Heads.GetAllocatedSize() + Counts.GetAllocatedSize();
+	}
+
+private:
+	TArray<T> Values;
+
+	// Slot each triangle's next entry is written to, and its number of entries
+	TArray<int32> Heads;
+	TArray<int32> Counts;
+
+	int32 Capacity = 1;
+};
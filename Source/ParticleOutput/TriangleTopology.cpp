@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TriangleTopology.h"
+
+// The original hand written topology, by Mixamo bone name. It was first written against the bone
+// indices of that skeleton, so the names keep its order of triangles
+static const TCHAR* DefaultTriangleBoneNames[][3] =
+{
+	// Center Symmetrical
+	{ TEXT("Head"), TEXT("LeftUpLeg"), TEXT("RightUpLeg") },
+	{ TEXT("Head"), TEXT("LeftToeBase"), TEXT("RightToeBase") },
+	{ TEXT("Spine1"), TEXT("LeftShoulder"), TEXT("RightShoulder") },
+	{ TEXT("Spine1"), TEXT("LeftHand"), TEXT("RightHand") },
+	{ TEXT("Spine1"), TEXT("LeftUpLeg"), TEXT("RightUpLeg") },
+
+	// Right Side Head
+	{ TEXT("Head"), TEXT("RightShoulder"), TEXT("Neck") },
+	{ TEXT("Head"), TEXT("RightShoulder"), TEXT("Spine1") },
+	{ TEXT("Head"), TEXT("RightArm"), TEXT("RightHand") },
+	{ TEXT("Head"), TEXT("RightArm"), TEXT("RightFoot") },
+
+	// Right Side Chest
+	{ TEXT("Spine1"), TEXT("RightShoulder"), TEXT("Neck") },
+	{ TEXT("Spine1"), TEXT("RightShoulder"), TEXT("RightHand") },
+	{ TEXT("Spine1"), TEXT("RightUpLeg"), TEXT("RightFoot") },
+	{ TEXT("Spine1"), TEXT("RightArm"), TEXT("RightHand") },
+
+	// Right Side Hip
+	{ TEXT("RightUpLeg"), TEXT("RightShoulder"), TEXT("LeftUpLeg") },
+	{ TEXT("RightUpLeg"), TEXT("RightShoulder"), TEXT("RightArm") },
+	{ TEXT("RightUpLeg"), TEXT("RightShoulder"), TEXT("RightHand") },
+	{ TEXT("RightUpLeg"), TEXT("Neck"), TEXT("RightShoulder") },
+	{ TEXT("RightUpLeg"), TEXT("RightArm"), TEXT("RightHand") },
+	{ TEXT("RightUpLeg"), TEXT("RightLeg"), TEXT("LeftLeg") },
+	{ TEXT("RightUpLeg"), TEXT("RightLeg"), TEXT("RightFoot") },
+
+	// Right Side Knee
+	{ TEXT("RightLeg"), TEXT("RightShoulder"), TEXT("RightArm") },
+	{ TEXT("RightLeg"), TEXT("RightShoulder"), TEXT("LeftLeg") },
+	{ TEXT("RightLeg"), TEXT("RightUpLeg"), TEXT("LeftUpLeg") },
+	{ TEXT("RightLeg"), TEXT("RightFoot"), TEXT("LeftFoot") },
+
+	// Right Side Ankle
+	{ TEXT("RightFoot"), TEXT("RightShoulder"), TEXT("LeftShoulder") },
+	{ TEXT("RightFoot"), TEXT("RightLeg"), TEXT("LeftLeg") },
+
+	// Left Side Head
+	{ TEXT("Head"), TEXT("LeftShoulder"), TEXT("Neck") },
+	{ TEXT("Head"), TEXT("LeftShoulder"), TEXT("Spine1") },
+	{ TEXT("Head"), TEXT("LeftArm"), TEXT("LeftHand") },
+	{ TEXT("Head"), TEXT("LeftArm"), TEXT("LeftFoot") },
+
+	// Left Side Chest
+	{ TEXT("Spine1"), TEXT("LeftShoulder"), TEXT("LeftArm") },
+	{ TEXT("Spine1"), TEXT("LeftShoulder"), TEXT("LeftHand") },
+	{ TEXT("Spine1"), TEXT("LeftUpLeg"), TEXT("LeftFoot") },
+	{ TEXT("Spine1"), TEXT("LeftArm"), TEXT("LeftHand") },
+
+	// Left Side Hip
+	{ TEXT("LeftUpLeg"), TEXT("LeftShoulder"), TEXT("RightUpLeg") },
+	{ TEXT("LeftUpLeg"), TEXT("LeftShoulder"), TEXT("LeftArm") },
+	{ TEXT("LeftUpLeg"), TEXT("LeftShoulder"), TEXT("LeftHand") },
+	{ TEXT("LeftUpLeg"), TEXT("Neck"), TEXT("LeftShoulder") },
+	{ TEXT("LeftUpLeg"), TEXT("LeftArm"), TEXT("LeftHand") },
+	{ TEXT("LeftUpLeg"), TEXT("LeftLeg"), TEXT("RightLeg") },
+	{ TEXT("LeftUpLeg"), TEXT("LeftLeg"), TEXT("LeftFoot") },
+
+	// Left Side Leg
+	{ TEXT("LeftLeg"), TEXT("LeftShoulder"), TEXT("LeftArm") },
+	{ TEXT("LeftLeg"), TEXT("LeftShoulder"), TEXT("RightLeg") },
+	{ TEXT("LeftLeg"), TEXT("LeftUpLeg"), TEXT("RightUpLeg") },
+	{ TEXT("LeftLeg"), TEXT("LeftFoot"), TEXT("RightFoot") },
+
+	// Left Side Ankle
+	{ TEXT("LeftFoot"), TEXT("LeftShoulder"), TEXT("RightShoulder") },
+	{ TEXT("LeftFoot"), TEXT("LeftLeg"), TEXT("RightLeg") },
+
+	// Cross Center
+	{ TEXT("Head"), TEXT("RightArm"), TEXT("LeftFoot") },
+	{ TEXT("Head"), TEXT("LeftArm"), TEXT("RightFoot") },
+	{ TEXT("Head"), TEXT("RightForeArm"), TEXT("LeftHand") },
+	{ TEXT("Head"), TEXT("LeftArm"), TEXT("RightHand") },
+	{ TEXT("Spine1"), TEXT("RightUpLeg"), TEXT("LeftHand") },
+	{ TEXT("Spine1"), TEXT("LeftUpLeg"), TEXT("RightHand") },
+	{ TEXT("Spine1"), TEXT("RightShoulder"), TEXT("LeftHand") },
+	{ TEXT("Spine1"), TEXT("LeftShoulder"), TEXT("RightHand") },
+	{ TEXT("RightUpLeg"), TEXT("LeftShoulder"), TEXT("RightArm") },
+	{ TEXT("LeftUpLeg"), TEXT("RightShoulder"), TEXT("LeftArm") },
+	{ TEXT("RightUpLeg"), TEXT("LeftShoulder"), TEXT("RightHand") },
+	{ TEXT("LeftUpLeg"), TEXT("RightShoulder"), TEXT("LeftHand") },
+	{ TEXT("RightUpLeg"), TEXT("LeftArm"), TEXT("RightHand") },
+	{ TEXT("LeftUpLeg"), TEXT("RightArm"), TEXT("LeftHand") },
+	{ TEXT("RightUpLeg"), TEXT("LeftLeg"), TEXT("RightHand") },
+	{ TEXT("LeftUpLeg"), TEXT("RightLeg"), TEXT("LeftHand") },
+	{ TEXT("RightUpLeg"), TEXT("LeftFoot"), TEXT("RightLeg") },
+	{ TEXT("LeftUpLeg"), TEXT("RightFoot"), TEXT("LeftLeg") },
+	{ TEXT("RightLeg"), TEXT("LeftShoulder"), TEXT("RightArm") },
+	{ TEXT("LeftLeg"), TEXT("RightShoulder"), TEXT("LeftArm") },
+
+};
+
+// Appends the socket indices of every triangle whose corners are all in SocketNames. A name also
+// matches a socket with a namespace in front of it, as in mixamorig:Head
+static int32 ResolveTriangles(const FString& TopologyName, TArrayView<const FTopologyTriangle> Triangles, const TArray<FName>& SocketNames, TArray<int32>& OutSocketIndices)
+{
+	TMap<FName, int32> SocketIndices;
+	SocketIndices.Reserve(SocketNames.Num() * 2);
+	for (int32 i = 0; i < SocketNames.Num(); i++)
+	{
+		SocketIndices.Add(SocketNames[i], i);
+	}
+	for (int32 i = 0; i < SocketNames.Num(); i++)
+	{
+		FString Namespace, Name;
+		if (SocketNames[i].ToString().Split(TEXT(":"), &Namespace, &Name, ESearchCase::CaseSensitive, ESearchDir::FromEnd)) {
+			SocketIndices.FindOrAdd(FName(*Name), i);
+		}
+	}
+
+	OutSocketIndices.Reserve(OutSocketIndices.Num() + Triangles.Num() * 3);
+	int32 Resolved = 0;
+	for (const FTopologyTriangle& Triangle : Triangles)
+	{
+		const int32* A = SocketIndices.Find(Triangle.A);
+		const int32* B = SocketIndices.Find(Triangle.B);
+		const int32* C = SocketIndices.Find(Triangle.C);
+		if (A == nullptr || B == nullptr || C == nullptr) {
+			UE_LOG(LogTemp, Warning, TEXT("%s: skipping triangle %s %s %s, socket not found"), *TopologyName, *Triangle.A.ToString(), *Triangle.B.ToString(), *Triangle.C.ToString());
+			continue;
+		}
+		OutSocketIndices.Add(*A);
+		OutSocketIndices.Add(*B);
+		OutSocketIndices.Add(*C);
+		Resolved++;
+	}
+	return Resolved;
+}
+
+int32 UTriangleTopology::Resolve(const TArray<FName>& SocketNames, TArray<int32>& OutSocketIndices) const
+{
+	return ResolveTriangles(GetName(), Triangles, SocketNames, OutSocketIndices);
+}
+
+int32 UTriangleTopology::ResolveDefault(const TArray<FName>& SocketNames, TArray<int32>& OutSocketIndices)
+{
+	// The names are made once, the first time a generator needs the default topology
+	static const TArray<FTopologyTriangle> DefaultTriangles = []()
+	{
+		TArray<FTopologyTriangle> Triangles;
+		Triangles.Reserve(UE_ARRAY_COUNT(DefaultTriangleBoneNames));
+		for (const TCHAR* const* Names : DefaultTriangleBoneNames)
+		{
+			FTopologyTriangle& Triangle = Triangles.AddDefaulted_GetRef();
+			Triangle.A = Names[0];
+			Triangle.B = Names[1];
+			Triangle.C = Names[2];
+		}
+		return Triangles;
+	}();
+	return ResolveTriangles(TEXT("Default topology"), DefaultTriangles, SocketNames, OutSocketIndices);
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "TriangleTopology.generated.h"
+
+// One triangle of a topology, named by the sockets at its corners
+USTRUCT(BlueprintType)
+struct FTopologyTriangle
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TriangleTopology")
+	FName A;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TriangleTopology")
+	FName B;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TriangleTopology")
+	FName C;
+};
+
+/*
+	The set of socket triangles an AParticleGenerator tracks. Triangles are stored
+	by socket name and resolved to socket indices once when the generator begins
+	play, so topologies can be added or swapped without recompiling.
+*/
+UCLASS(BlueprintType)
+class PARTICLEOUTPUT_API UTriangleTopology : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TriangleTopology")
+	TArray<FTopologyTriangle> Triangles;
+
+	// Appends three socket indices per triangle to OutSocketIndices. Triangles with a
+	// corner that is not in SocketNames are skipped and logged. Returns the number resolved.
+	int32 Resolve(const TArray<FName>& SocketNames, TArray<int32>& OutSocketIndices) const;
+
+	// Same as Resolve, for the built in 67 triangle topology used when no asset is set.
+	// The built in table names bones of the Mixamo skeleton, so sockets added to the mesh
+	// or a different bone order no longer shift its corners.
+	static int32 ResolveDefault(const TArray<FName>& SocketNames, TArray<int32>& OutSocketIndices);
+};